@@ -0,0 +1,215 @@
+/**
+ *  @file   arena.hpp
+ *  @brief    Implement bump-pointer arena and allocator of memory resources for values.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#ifndef _JSONCXX_ARENA_H_
+#define _JSONCXX_ARENA_H_
+
+#include <cstddef>    // size_t, max_align_t
+#include <new>        // operator new
+#include <vector>
+
+//! With C++17, values allocate from any std::pmr::memory_resource, and Arena is one of them.
+//! Define JSONCXX_NO_MEMORY_RESOURCE to allocate from Arena only.
+#if !defined(JSONCXX_NO_MEMORY_RESOURCE) && defined(__has_include)
+#if __has_include(<memory_resource>) && \
+    ((defined(_MSVC_LANG) && _MSVC_LANG >= 201703L) || __cplusplus >= 201703L)
+#define JSONCXX_MEMORY_RESOURCE
+#endif
+#endif
+
+#ifdef JSONCXX_MEMORY_RESOURCE
+#include <memory_resource>
+#endif
+
+//! Size in bytes of the first chunk of an Arena. Each further chunk doubles it.
+#ifndef JSONCXX_ARENA_CHUNK_SIZE
+#define JSONCXX_ARENA_CHUNK_SIZE (64 * 1024)
+#endif
+
+//! Largest size in bytes of a chunk of an Arena, unless a single allocation needs more.
+#ifndef JSONCXX_ARENA_MAX_CHUNK_SIZE
+#define JSONCXX_ARENA_MAX_CHUNK_SIZE (64 * 1024 * 1024)
+#endif
+
+namespace jsoncxx {
+
+class Arena;
+
+//! Source of memory for strings and containers of values.
+#ifdef JSONCXX_MEMORY_RESOURCE
+typedef std::pmr::memory_resource MemoryResource;
+#else
+typedef Arena MemoryResource;
+#endif
+
+//! Bump-pointer memory arena.
+/*! Memory is carved from large chunks and is never freed one allocation at a time;
+    reset() makes all of it available again at once, keeping the chunks for reuse,
+    and release() or the destructor returns the chunks.
+    Destructors of objects placed in the arena are not called by it.
+    With C++17, it is a std::pmr::memory_resource whose chunks may come from an upstream resource.
+ */
+class Arena
+#ifdef JSONCXX_MEMORY_RESOURCE
+  : public std::pmr::memory_resource
+#endif
+{
+ public:
+  //! Constructor.
+  /*! \param chunkSize Size in bytes of the first chunk, which is allocated on the first allocation.
+   */
+  explicit Arena(size_t chunkSize = JSONCXX_ARENA_CHUNK_SIZE)
+    : chunkSize_(chunkSize > 0 ? chunkSize : 1), current_(0), used_(0) {
+#ifdef JSONCXX_MEMORY_RESOURCE
+    upstream_ = std::pmr::new_delete_resource();
+#endif
+  }
+
+#ifdef JSONCXX_MEMORY_RESOURCE
+  //! Constructor taking the chunks from upstream, e.g. a resource of memory local to a NUMA node.
+  Arena(size_t chunkSize, std::pmr::memory_resource* upstream)
+    : chunkSize_(chunkSize > 0 ? chunkSize : 1), current_(0), used_(0), upstream_(upstream) {}
+#endif
+
+  ~Arena() { release(); }
+
+  //! Allocate memory, aligned at most to max_align_t.
+  void* allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+    JSONCXX_ASSERT(align <= alignof(std::max_align_t) && (align & (align - 1)) == 0);
+
+    for (;;) {
+      if (current_ < chunks_.size()) {
+        size_t offset = (used_ + align - 1) & ~(align - 1);
+        if (offset + size <= chunks_[current_].size_) {
+          used_ = offset + size;
+          return chunks_[current_].data_ + offset;
+        }
+        if (current_ + 1 < chunks_.size()) {  // reuse a chunk kept by reset()
+          ++current_;
+          used_ = 0;
+          continue;
+        }
+      }
+      grow(size);
+    }
+  }
+
+  //! Do nothing, since memory is reclaimed by reset().
+  inline void deallocate(void*, size_t, size_t = alignof(std::max_align_t)) {}
+
+  //! Make all memory available again, keeping the chunks.
+  void reset() {
+    current_ = 0;
+    used_ = 0;
+  }
+
+  //! Free all chunks.
+  void release() {
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+#ifdef JSONCXX_MEMORY_RESOURCE
+      upstream_->deallocate(chunks_[i].data_, chunks_[i].size_);
+#else
+      ::operator delete(chunks_[i].data_);
+#endif
+    }
+    chunks_.clear();
+    reset();
+  }
+
+  //! Get the total size in bytes of the chunks.
+  size_t capacity() const {
+    size_t total = 0;
+    for (size_t i = 0; i < chunks_.size(); ++i)
+      total += chunks_[i].size_;
+    return total;
+  }
+
+ private:
+  Arena(const Arena&);
+  Arena& operator= (const Arena&);
+
+#ifdef JSONCXX_MEMORY_RESOURCE
+  void* do_allocate(size_t size, size_t align) override { return allocate(size, align); }
+  void do_deallocate(void*, size_t, size_t) override {}
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+#endif
+
+  struct Chunk {
+    char*   data_;
+    size_t  size_;
+  };
+
+  //! Append a chunk large enough for size bytes and make it current.
+  void grow(size_t size) {
+    size_t chunkSize = chunkSize_;
+    if (!chunks_.empty())
+      chunkSize = chunks_.back().size_ < JSONCXX_ARENA_MAX_CHUNK_SIZE / 2 ? chunks_.back().size_ * 2 : JSONCXX_ARENA_MAX_CHUNK_SIZE;
+    if (chunkSize < size)
+      chunkSize = size;
+
+#ifdef JSONCXX_MEMORY_RESOURCE
+    Chunk chunk = { static_cast<char*>(upstream_->allocate(chunkSize)), chunkSize };
+#else
+    Chunk chunk = { static_cast<char*>(::operator new(chunkSize)), chunkSize };
+#endif
+    chunks_.push_back(chunk);
+    current_ = chunks_.size() - 1;
+    used_ = 0;
+  }
+
+  size_t              chunkSize_; //!< Size of the first chunk.
+  std::vector<Chunk>  chunks_;
+  size_t              current_;   //!< Index of the chunk allocated from.
+  size_t              used_;      //!< Bytes used in the current chunk.
+#ifdef JSONCXX_MEMORY_RESOURCE
+  std::pmr::memory_resource* upstream_; //!< Resource of the chunks.
+#endif
+};
+
+//! Allocator of containers of values, which allocates from a MemoryResource or, without one, from the heap.
+/*! \tparam T Type of allocated objects.
+ */
+template <typename T>
+class ValueAllocator {
+ public:
+  typedef T value_type;
+
+  ValueAllocator(MemoryResource* resource = 0) noexcept : resource_(resource) {}
+
+  template <typename U>
+  ValueAllocator(const ValueAllocator<U>& other) noexcept : resource_(other.resource()) {}
+
+  T* allocate(size_t n) {
+    if (resource_)
+      return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, size_t n) noexcept {
+    if (resource_)
+      resource_->deallocate(p, n * sizeof(T), alignof(T));
+    else
+      ::operator delete(p);
+  }
+
+  //! Get the resource, or null for the heap.
+  inline MemoryResource* resource() const { return resource_; }
+
+  template <typename U>
+  inline bool operator== (const ValueAllocator<U>& other) const { return resource_ == other.resource(); }
+  template <typename U>
+  inline bool operator!= (const ValueAllocator<U>& other) const { return resource_ != other.resource(); }
+
+ private:
+  MemoryResource* resource_;
+};
+
+}
+
+#endif // _JSONCXX_ARENA_H_
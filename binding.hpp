@@ -0,0 +1,270 @@
+/**
+ *  @file   binding.hpp
+ *  @brief    Implement reader parsing directly into C++ structs bound to JSON at compile time.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#ifndef _JSONCXX_BINDING_H_
+#define _JSONCXX_BINDING_H_
+
+#include "reader.hpp"
+
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jsoncxx {
+
+//! Fields of a struct bound to the members of a JSON object.
+/*! Specialize it for a struct with a static function which passes the name and the pointer of each
+    bound member to a visitor. The members are read by BindReader without building a Value.
+
+    @code
+    struct Point {
+      int x, y;
+      std::string label;
+      std::vector<Point> children;
+    };
+
+    namespace jsoncxx {
+    template <> struct Binding<Point> {
+      template <typename Visitor>
+      static void fields(Visitor& visit) {
+        visit("x", &Point::x);
+        visit("y", &Point::y);
+        visit("label", &Point::label);
+        visit("children", &Point::children);
+      }
+    };
+    }
+    @endcode
+
+    \tparam T Bound struct.
+ */
+template <typename T>
+struct Binding;
+
+//! Reader which parses a value into a bound struct, or any type a bound member can have.
+/*! Members can be bool, arithmetic types, strings, std::vector of those, bound structs and Value.
+    The name of each member of an object is matched to the fields of Binding, and the value is parsed
+    directly into the bound member; members without a field are skipped.
+    A member which is missing or null keeps its value, and a value of another type is a parsing error.
+
+    @code
+    Point point;
+    jsoncxx::StringStream<jsoncxx::UTF8<> > s(json);
+    jsoncxx::BindReader<jsoncxx::StringStream<jsoncxx::UTF8<> > >().parse(s, point);
+    @endcode
+
+    \tparam Stream Input stream.
+    \tparam Encoding Encoding of the input.
+ */
+template <typename Stream, typename Encoding = UTF8<> >
+class BindReader {
+ public:
+  typedef typename Encoding::char_type  char_type;
+  typedef std::basic_string<char_type>  string;
+  typedef Value<Encoding>               value_type;
+
+  //! Parse a value from stream into obj.
+  template <typename T>
+  void parse(Stream& s, T& obj) {
+    read(s, obj);
+  }
+
+ private:
+  //! Handler which keeps the type of a value, and the value of a string, a number or a literal.
+  /*! Events of the elements and members of a container are ignored.
+   */
+  struct ScalarHandler : public BaseHandler<Encoding> {
+    explicit ScalarHandler(std::basic_string<char_type>* str = 0) : type_(NullType), first_(true), str_(str) {}
+
+    void null()                 { first(NullType); }
+    void boolean(bool b)        { first(b ? TrueType : FalseType); }
+    void number(natural n)      { if (first(NumberType)) { real_ = false; n_ = n; } }
+    void number(real r)         { if (first(NumberType)) { real_ = true; r_ = r; } }
+
+    void string(const char_type* str, size_type length, bool) {
+      if (first(StringType) && str_)
+        str_->assign(str, length);
+    }
+
+    void startObject()          { first(ObjectType); }
+    void startArray()           { first(ArrayType); }
+
+    inline bool first(ValueType type) {
+      if (!first_)
+        return false;
+      first_ = false;
+      type_ = type;
+      return true;
+    }
+
+    ValueType type_;
+    bool      first_;           //!< Whether no event has been reported yet.
+    bool      real_;
+    natural   n_;
+    real      r_;
+    std::basic_string<char_type>* str_; //!< String to assign to, if a string is expected.
+  };
+
+  //! Visitor of Binding<T>::fields which reads the member whose name is key.
+  template <typename T>
+  class FieldVisitor {
+   public:
+    FieldVisitor(BindReader& reader, Stream& s, T& obj, const string& key)
+      : reader_(reader), s_(s), obj_(obj), key_(key), found_(false) {}
+
+    template <typename M>
+    void operator() (const char* name, M T::* member) {
+      if (!found_ && match(name)) {
+        found_ = true;
+        reader_.read(s_, obj_.*member);
+      }
+    }
+
+    inline bool found() const { return found_; }
+
+   private:
+    FieldVisitor& operator= (const FieldVisitor&);
+
+    inline bool match(const char* name) const {
+      size_t i = 0;
+      for (; i < key_.size() && name[i] != '\0'; ++i)
+        if (key_[i] != static_cast<char_type>(static_cast<unsigned char>(name[i])))
+          return false;
+      return i == key_.size() && name[i] == '\0';
+    }
+
+    BindReader&   reader_;
+    Stream&       s_;
+    T&            obj_;
+    const string& key_;
+    bool          found_;
+  };
+
+  //! Parse a value which must have the type expected, and return its handler. A null value is accepted.
+  ScalarHandler readScalar(Stream& s, ValueType expected, string* str = 0) {
+    ScalarHandler handler(str);
+    reader_.parse(s, handler);
+    if (handler.type_ != NullType && handler.type_ != expected &&
+        !(expected == TrueType && handler.type_ == FalseType))
+      JSONCXX_PARSING_ERROR("Type of value does not match the bound member");
+    return handler;
+  }
+
+  void read(Stream& s, bool& b) {
+    ScalarHandler handler = readScalar(s, TrueType);
+    if (handler.type_ != NullType)
+      b = handler.type_ == TrueType;
+  }
+
+  //! Read an integer or a floating-point number. An integer must be read from an integral number in its range.
+  template <typename T>
+  typename std::enable_if<std::is_arithmetic<T>::value>::type read(Stream& s, T& number) {
+    ScalarHandler handler = readScalar(s, NumberType);
+    if (handler.type_ == NullType)
+      return;
+
+    if (std::is_floating_point<T>::value)
+      number = handler.real_ ? static_cast<T>(handler.r_) : static_cast<T>(handler.n_);
+    else {
+      if (handler.real_ || handler.n_ < static_cast<natural>(std::numeric_limits<T>::min()) ||
+          (handler.n_ > 0 && static_cast<unsigned long long>(handler.n_) > static_cast<unsigned long long>(std::numeric_limits<T>::max())))
+        JSONCXX_PARSING_ERROR("Number does not fit in the bound member");
+      number = static_cast<T>(handler.n_);
+    }
+  }
+
+  void read(Stream& s, string& str) {
+    readScalar(s, StringType, &str);
+  }
+
+  void read(Stream& s, value_type& value) {
+    value = reader_.parse(s);
+  }
+
+  //! Read the elements of a vector. Each one is read into a local element, since std::vector<bool> has no references to them.
+  template <typename T, typename Allocator>
+  void read(Stream& s, std::vector<T, Allocator>& elements) {
+    SkipWhitespace(s);
+    if (s.peek() != '[') {
+      readScalar(s, ArrayType);
+      return;
+    }
+
+    s.take();
+    elements.clear();
+    SkipWhitespace(s);
+    if (s.peek() == ']') {
+      s.take();
+      return;
+    }
+
+    for (;;) {
+      T element = T();
+      read(s, element);
+      elements.push_back(std::move(element));
+      SkipWhitespace(s);
+
+      switch (s.take()) {
+      case ',': break;
+      case ']': return;
+      default: JSONCXX_PARSING_ERROR("Must be a comma or ']' after an array member");
+      }
+    }
+  }
+
+  //! Read a struct bound by Binding<T>.
+  template <typename T>
+  typename std::enable_if<std::is_class<T>::value>::type read(Stream& s, T& obj) {
+    SkipWhitespace(s);
+    if (s.peek() != '{') {
+      readScalar(s, ObjectType);
+      return;
+    }
+
+    s.take();
+    SkipWhitespace(s);
+    if (s.peek() == '}') {
+      s.take();
+      return;
+    }
+
+    string key;
+    for (;;) {
+      if (s.peek() != '"')
+        JSONCXX_PARSING_ERROR("Name of an object member must be a string");
+      readScalar(s, StringType, &key);
+
+      SkipWhitespace(s);
+      if (s.take() != ':')
+        JSONCXX_PARSING_ERROR("There must be a colon after the name of object member");
+
+      FieldVisitor<T> visitor(*this, s, obj, key);
+      Binding<T>::fields(visitor);
+      if (!visitor.found()) {
+        BaseHandler<Encoding> skip;
+        reader_.parse(s, skip);
+      }
+
+      SkipWhitespace(s);
+      switch (s.take()) {
+      case ',': SkipWhitespace(s); break;
+      case '}': return;
+      default: JSONCXX_PARSING_ERROR("Must be a comma or '}' after an object member");
+      }
+    }
+  }
+
+  Reader<Stream, Encoding> reader_; //!< Reader parsing strings, numbers, literals and skipped values.
+};
+
+}
+
+#endif // _JSONCXX_BINDING_H_
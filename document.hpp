@@ -0,0 +1,110 @@
+/**
+ *  @file   document.hpp
+ *  @brief    Implement document owning all memory of its values in an arena.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#ifndef _JSONCXX_DOCUMENT_H_
+#define _JSONCXX_DOCUMENT_H_
+
+#include "arena.hpp"
+#include "reader.hpp"
+
+#include <new>        // placement new
+
+namespace jsoncxx {
+
+//! Document whose strings, elements and members are all allocated from its own Arena.
+/*! Parsing takes a few large chunks instead of an allocation per string and container, and the
+    values are never destroyed one by one: clear(), the next parse() and the destructor drop the
+    whole tree by resetting the arena. The chunks are kept for reuse until the document is destroyed,
+    so a document reused across requests stops allocating once its arena has grown.
+
+    @code
+    jsoncxx::document doc;
+    for (;;) {
+      jsoncxx::stringstream s(next_request());
+      doc.parse(s);
+      process(doc.root());
+    }
+    @endcode
+
+    Values of the tree must not outlive the document; copy a value to keep it, since the copy is
+    allocated from the heap. Values added to the tree should be created with arena(), as in
+    Value(ArrayType, &doc.arena()), because heap memory of values in the tree is never freed.
+    \tparam Encoding Encoding of the values.
+ */
+template <typename Encoding = UTF8<> >
+class Document {
+ public:
+  typedef Value<Encoding> value_type;
+
+  //! Constructor.
+  /*! \param chunkSize Size in bytes of the first chunk of the arena.
+   */
+  explicit Document(size_t chunkSize = JSONCXX_ARENA_CHUNK_SIZE) : arena_(chunkSize), root_(0) {
+    clear();
+  }
+
+#ifdef JSONCXX_MEMORY_RESOURCE
+  //! Constructor taking the chunks of the arena from upstream, e.g. a resource of memory local to a NUMA node.
+  Document(size_t chunkSize, std::pmr::memory_resource* upstream) : arena_(chunkSize, upstream), root_(0) {
+    clear();
+  }
+#endif
+
+  //! Parse a value from stream as the root, replacing the current one.
+  /*! Throws parsing_error on error, in which case the root is null.
+   */
+  template <unsigned parseFlags = ParseDefaultFlags, typename Stream>
+  void parse(Stream& s) {
+    ParseResult result = tryParse<parseFlags>(s);
+    if (!result)
+      JSONCXX_PARSING_ERROR(result.message());
+  }
+
+  //! Parse a value from stream as the root, replacing the current one, without throwing on parsing errors.
+  /*! On error, the root is null. The arena allocates, so std::bad_alloc is thrown if memory runs out,
+      in which case the root is null as well.
+   */
+  template <unsigned parseFlags = ParseDefaultFlags, typename Stream>
+  ParseResult tryParse(Stream& s) {
+    clear();
+    ParseResult result;
+    try {
+      result = Reader<Stream, Encoding>().template tryParse<parseFlags>(s, *root_, &arena_);
+    } catch (...) {
+      clear();
+      throw;
+    }
+    if (!result)
+      clear();
+    return result;
+  }
+
+  //! Drop the tree at once and make the root null.
+  void clear() {
+    arena_.reset();
+    root_ = new (arena_.allocate(sizeof(value_type), alignof(value_type))) value_type();
+  }
+
+  inline value_type& root()             { return *root_; }
+  inline const value_type& root() const { return *root_; }
+
+  //! Get the arena to create values added to the tree from.
+  inline Arena& arena()                 { return arena_; }
+
+ private:
+  Document(const Document&);
+  Document& operator= (const Document&);
+
+  Arena       arena_;
+  value_type* root_;  //!< Root value, which is allocated from the arena and never destroyed.
+};
+
+}
+
+#endif // _JSONCXX_DOCUMENT_H_
@@ -10,6 +10,12 @@
 #ifndef _JSONCXX_ENCODING_H_
 #define _JSONCXX_ENCODING_H_
 
+#include "simd.hpp"
+
+#include <cstddef>      // size_t
+#include <cstring>      // memcpy
+#include <string>
+
 namespace jsoncxx {
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -31,10 +37,254 @@ namespace jsoncxx {
         //! \param codepoint An unicode codepoint, ranging from 0x0 to 0x10FFFF inclusively.
         //! \returns the pointer to the next character after the encoded data.
         static char_type* Encode(char_type *buffer, unsigned codepoint);
+
+        //! \brief Decode a Unicode codepoint from characters.
+        //! \param p pointer to the first character, which is moved past the decoded ones.
+        //! \param end pointer past the last readable character.
+        //! \param codepoint decoded codepoint.
+        //! \returns false if the characters are ill-formed, in which case one character is skipped.
+        static bool Decode(const char_type*& p, const char_type* end, char32_t& codepoint);
+
+        //! \brief Check whether characters are well-formed in the encoding.
+        //! \returns false for a truncated or overlong sequence, a lone surrogate, or a codepoint beyond 0x10FFFF.
+        static bool Validate(const char_type* str, size_t length);
     };
     \endcode
  */
 
+///////////////////////////////////////////////////////////////////////////////
+// ValidateUTF8
+
+//! Check whether bytes are well-formed UTF-8, one character at a time.
+inline bool ValidateUTF8_Scalar(const char* str, size_t length) {
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(str);
+  const unsigned char* end = p + length;
+
+  while (p != end) {
+    unsigned c = *p++;
+    if (c < 0x80)
+      continue;
+
+    // number of continuation bytes, and the range of the first one which excludes
+    // overlong sequences, surrogates and codepoints beyond 0x10FFFF
+    size_t n;
+    unsigned low = 0x80, high = 0xBF;
+    if (c >= 0xC2 && c <= 0xDF)
+      n = 1;
+    else if (c >= 0xE0 && c <= 0xEF) {
+      n = 2;
+      if (c == 0xE0) low = 0xA0;
+      if (c == 0xED) high = 0x9F;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+      n = 3;
+      if (c == 0xF0) low = 0x90;
+      if (c == 0xF4) high = 0x8F;
+    } else
+      return false;
+
+    if (static_cast<size_t>(end - p) < n || p[0] < low || p[0] > high)
+      return false;
+    for (size_t i = 1; i < n; ++i)
+      if ((p[i] & 0xC0) != 0x80)
+        return false;
+    p += n;
+  }
+  return true;
+}
+
+#ifdef JSONCXX_SIMD
+//! @name Lookup tables of the SIMD UTF-8 validation.
+/*! Errors of the pairs of consecutive bytes are found by looking up the high nibble of the first byte,
+    the low nibble of the first byte and the high nibble of the second byte in three tables of bit flags,
+    and taking their intersection (Keiser and Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte").
+    The third and fourth bytes of a sequence are checked by their distance from the leading byte.
+ */
+//! @{
+enum {
+  Utf8TooShort      = 1 << 0, //!< Leading byte followed by a leading byte or ASCII.
+  Utf8TooLong       = 1 << 1, //!< ASCII followed by a continuation byte.
+  Utf8Overlong3     = 1 << 2, //!< 1110_0000 100_____
+  Utf8TooLarge      = 1 << 3, //!< 1111_0100 1001____ and above
+  Utf8Surrogate     = 1 << 4, //!< 1110_1101 101_____
+  Utf8Overlong2     = 1 << 5, //!< 1100_000_ 10______
+  Utf8TooLarge1000  = 1 << 6, //!< 1111_0101 1000____ and above
+  Utf8Overlong4     = 1 << 6, //!< 1111_0000 1000____
+  Utf8TwoConts      = 1 << 7, //!< Two continuation bytes, which is an error unless they follow a 3 or 4-byte leading byte.
+  Utf8Carry         = Utf8TooShort | Utf8TooLong | Utf8TwoConts,
+};
+
+#define JSONCXX_UTF8_BYTE_1_HIGH \
+  Utf8TooLong, Utf8TooLong, Utf8TooLong, Utf8TooLong, \
+  Utf8TooLong, Utf8TooLong, Utf8TooLong, Utf8TooLong, \
+  Utf8TwoConts, Utf8TwoConts, Utf8TwoConts, Utf8TwoConts, \
+  Utf8TooShort | Utf8Overlong2, \
+  Utf8TooShort, \
+  Utf8TooShort | Utf8Overlong3 | Utf8Surrogate, \
+  Utf8TooShort | Utf8TooLarge | Utf8TooLarge1000 | Utf8Overlong4
+
+#define JSONCXX_UTF8_BYTE_1_LOW \
+  Utf8Carry | Utf8Overlong3 | Utf8Overlong2 | Utf8Overlong4, \
+  Utf8Carry | Utf8Overlong2, \
+  Utf8Carry, \
+  Utf8Carry, \
+  Utf8Carry | Utf8TooLarge, \
+  Utf8Carry | Utf8TooLarge | Utf8TooLarge1000, \
+  Utf8Carry | Utf8TooLarge | Utf8TooLarge1000, \
+  Utf8Carry | Utf8TooLarge | Utf8TooLarge1000, \
+  Utf8Carry | Utf8TooLarge | Utf8TooLarge1000, \
+  Utf8Carry | Utf8TooLarge | Utf8TooLarge1000, \
+  Utf8Carry | Utf8TooLarge | Utf8TooLarge1000, \
+  Utf8Carry | Utf8TooLarge | Utf8TooLarge1000, \
+  Utf8Carry | Utf8TooLarge | Utf8TooLarge1000, \
+  Utf8Carry | Utf8TooLarge | Utf8TooLarge1000 | Utf8Surrogate, \
+  Utf8Carry | Utf8TooLarge | Utf8TooLarge1000, \
+  Utf8Carry | Utf8TooLarge | Utf8TooLarge1000
+
+#define JSONCXX_UTF8_BYTE_2_HIGH \
+  Utf8TooShort, Utf8TooShort, Utf8TooShort, Utf8TooShort, \
+  Utf8TooShort, Utf8TooShort, Utf8TooShort, Utf8TooShort, \
+  Utf8TooLong | Utf8Overlong2 | Utf8TwoConts | Utf8Overlong3 | Utf8TooLarge1000 | Utf8Overlong4, \
+  Utf8TooLong | Utf8Overlong2 | Utf8TwoConts | Utf8Overlong3 | Utf8TooLarge, \
+  Utf8TooLong | Utf8Overlong2 | Utf8TwoConts | Utf8Surrogate | Utf8TooLarge, \
+  Utf8TooLong | Utf8Overlong2 | Utf8TwoConts | Utf8Surrogate | Utf8TooLarge, \
+  Utf8TooShort, Utf8TooShort, Utf8TooShort, Utf8TooShort
+//! @}
+
+//! Validate UTF-8 with SSE4.2 instructions, testing 16 bytes at once.
+JSONCXX_TARGET("sse4.2")
+inline bool ValidateUTF8_SSE42(const char* str, size_t length) {
+  const __m128i byte1High = _mm_setr_epi8(JSONCXX_UTF8_BYTE_1_HIGH);
+  const __m128i byte1Low  = _mm_setr_epi8(JSONCXX_UTF8_BYTE_1_LOW);
+  const __m128i byte2High = _mm_setr_epi8(JSONCXX_UTF8_BYTE_2_HIGH);
+  const __m128i nibble    = _mm_set1_epi8(0x0F);
+  // the last bytes of a block which start a sequence not ending in it
+  const __m128i incompleteMax = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                              (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+
+  __m128i error = _mm_setzero_si128();
+  __m128i previous = _mm_setzero_si128();
+  __m128i incomplete = _mm_setzero_si128();
+
+  for (size_t i = 0; i < length; i += 16) {
+    __m128i input;
+    if (length - i >= 16)
+      input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i));
+    else {
+      char tail[16];
+      std::memset(tail, ' ', sizeof(tail));
+      std::memcpy(tail, str + i, length - i);
+      input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tail));
+    }
+
+    if (_mm_movemask_epi8(input) == 0) { // ASCII
+      error = _mm_or_si128(error, incomplete);
+      previous = input;
+      continue;
+    }
+
+    __m128i prev1 = _mm_alignr_epi8(input, previous, 15);
+    __m128i special = _mm_and_si128(
+      _mm_and_si128(_mm_shuffle_epi8(byte1High, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+                    _mm_shuffle_epi8(byte1Low, _mm_and_si128(prev1, nibble))),
+      _mm_shuffle_epi8(byte2High, _mm_and_si128(_mm_srli_epi16(input, 4), nibble)));
+
+    __m128i prev2 = _mm_alignr_epi8(input, previous, 14);
+    __m128i prev3 = _mm_alignr_epi8(input, previous, 13);
+    __m128i must23 = _mm_or_si128(_mm_subs_epu8(prev2, _mm_set1_epi8((char)(0xE0 - 0x80))),
+                                  _mm_subs_epu8(prev3, _mm_set1_epi8((char)(0xF0 - 0x80))));
+    must23 = _mm_and_si128(must23, _mm_set1_epi8((char)0x80));
+    error = _mm_or_si128(error, _mm_xor_si128(must23, special));
+
+    incomplete = _mm_subs_epu8(input, incompleteMax);
+    previous = input;
+  }
+
+  error = _mm_or_si128(error, incomplete);
+  return _mm_testz_si128(error, error) != 0;
+}
+
+//! Validate UTF-8 with AVX2 instructions, testing 32 bytes at once.
+JSONCXX_TARGET("avx2")
+inline bool ValidateUTF8_AVX2(const char* str, size_t length) {
+  const __m256i byte1High = _mm256_setr_epi8(JSONCXX_UTF8_BYTE_1_HIGH, JSONCXX_UTF8_BYTE_1_HIGH);
+  const __m256i byte1Low  = _mm256_setr_epi8(JSONCXX_UTF8_BYTE_1_LOW, JSONCXX_UTF8_BYTE_1_LOW);
+  const __m256i byte2High = _mm256_setr_epi8(JSONCXX_UTF8_BYTE_2_HIGH, JSONCXX_UTF8_BYTE_2_HIGH);
+  const __m256i nibble    = _mm256_set1_epi8(0x0F);
+  const __m256i incompleteMax = _mm256_setr_epi8(
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+
+  __m256i error = _mm256_setzero_si256();
+  __m256i previous = _mm256_setzero_si256();
+  __m256i incomplete = _mm256_setzero_si256();
+
+  for (size_t i = 0; i < length; i += 32) {
+    __m256i input;
+    if (length - i >= 32)
+      input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + i));
+    else {
+      char tail[32];
+      std::memset(tail, ' ', sizeof(tail));
+      std::memcpy(tail, str + i, length - i);
+      input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tail));
+    }
+
+    if (_mm256_movemask_epi8(input) == 0) { // ASCII
+      error = _mm256_or_si256(error, incomplete);
+      previous = input;
+      continue;
+    }
+
+    // bytes before those of input, crossing the lanes
+    __m256i shifted = _mm256_permute2x128_si256(previous, input, 0x21);
+    __m256i prev1 = _mm256_alignr_epi8(input, shifted, 15);
+    __m256i special = _mm256_and_si256(
+      _mm256_and_si256(_mm256_shuffle_epi8(byte1High, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+                       _mm256_shuffle_epi8(byte1Low, _mm256_and_si256(prev1, nibble))),
+      _mm256_shuffle_epi8(byte2High, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble)));
+
+    __m256i prev2 = _mm256_alignr_epi8(input, shifted, 14);
+    __m256i prev3 = _mm256_alignr_epi8(input, shifted, 13);
+    __m256i must23 = _mm256_or_si256(_mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0 - 0x80))),
+                                     _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0 - 0x80))));
+    must23 = _mm256_and_si256(must23, _mm256_set1_epi8((char)0x80));
+    error = _mm256_or_si256(error, _mm256_xor_si256(must23, special));
+
+    incomplete = _mm256_subs_epu8(input, incompleteMax);
+    previous = input;
+  }
+
+  error = _mm256_or_si256(error, incomplete);
+  return _mm256_testz_si256(error, error) != 0;
+}
+
+#undef JSONCXX_UTF8_BYTE_1_HIGH
+#undef JSONCXX_UTF8_BYTE_1_LOW
+#undef JSONCXX_UTF8_BYTE_2_HIGH
+#endif // JSONCXX_SIMD
+
+//! Check whether bytes are well-formed UTF-8 with the best kernel for the host, which is selected on the first call.
+/*! Short strings, which are mostly ASCII names and values in JSON, are checked without dispatching.
+ */
+inline bool ValidateUTF8(const char* str, size_t length) {
+  if (length < 16) {
+    size_t i = 0;
+    while (i < length && static_cast<unsigned char>(str[i]) < 0x80)
+      ++i;
+    if (i == length)
+      return true;
+  }
+
+#ifdef JSONCXX_SIMD
+  static bool (*const kernel)(const char*, size_t) =
+    GetSimdLevel() >= SimdAVX2 ? &ValidateUTF8_AVX2 : GetSimdLevel() >= SimdSSE42 ? &ValidateUTF8_SSE42 : &ValidateUTF8_Scalar;
+  return kernel(str, length);
+#else
+  return ValidateUTF8_Scalar(str, length);
+#endif
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // UTF8
 
@@ -66,6 +316,49 @@ struct UTF8 {
     }
     return buffer;
   }
+
+  static bool Decode(const char_type*& p, const char_type* end, char32_t& codepoint) {
+    unsigned c = static_cast<unsigned char>(*p++);
+    if (c < 0x80) {
+      codepoint = c;
+      return true;
+    }
+
+    // number of continuation bytes, and the range of the first one as in ValidateUTF8_Scalar()
+    size_t n;
+    unsigned low = 0x80, high = 0xBF;
+    if (c >= 0xC2 && c <= 0xDF)
+      n = 1;
+    else if (c >= 0xE0 && c <= 0xEF) {
+      n = 2;
+      if (c == 0xE0) low = 0xA0;
+      if (c == 0xED) high = 0x9F;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+      n = 3;
+      if (c == 0xF0) low = 0x90;
+      if (c == 0xF4) high = 0x8F;
+    } else
+      return false;
+
+    if (static_cast<size_t>(end - p) < n)
+      return false;
+    unsigned first = static_cast<unsigned char>(p[0]);
+    if (first < low || first > high)
+      return false;
+    codepoint = c & (0x3F >> n);
+    for (size_t i = 0; i < n; ++i) {
+      unsigned b = static_cast<unsigned char>(p[i]);
+      if ((b & 0xC0) != 0x80)
+        return false;
+      codepoint = (codepoint << 6) | (b & 0x3F);
+    }
+    p += n;
+    return true;
+  }
+
+  static bool Validate(const char_type* str, size_t length) {
+    return ValidateUTF8(reinterpret_cast<const char*>(str), length);
+  }
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -92,6 +385,38 @@ struct UTF16 {
     }
     return buffer;
   }
+
+  static bool Decode(const char_type*& p, const char_type* end, char32_t& codepoint) {
+    unsigned c = static_cast<unsigned>(*p++) & 0xFFFF;
+    if (c < 0xD800 || c > 0xDFFF) {
+      codepoint = c;
+      return true;
+    }
+    if (c > 0xDBFF || p == end) // lone low surrogate, or high surrogate at the end
+      return false;
+
+    unsigned low = static_cast<unsigned>(*p) & 0xFFFF;
+    if (low < 0xDC00 || low > 0xDFFF)
+      return false;
+    ++p;
+    codepoint = (((c - 0xD800) << 10) | (low - 0xDC00)) + 0x10000;
+    return true;
+  }
+
+  static bool Validate(const char_type* str, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+      unsigned c = static_cast<unsigned>(str[i]) & 0xFFFF;
+      if (c >= 0xD800 && c <= 0xDBFF) { // high surrogate must be followed by low surrogate
+        if (++i == length)
+          return false;
+        unsigned low = static_cast<unsigned>(str[i]) & 0xFFFF;
+        if (low < 0xDC00 || low > 0xDFFF)
+          return false;
+      } else if (c >= 0xDC00 && c <= 0xDFFF)
+        return false;
+    }
+    return true;
+  }
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -111,8 +436,276 @@ struct UTF32 {
     *buffer++ = codepoint;
     return buffer;
   }
+
+  static bool Decode(const char_type*& p, const char_type*, char32_t& codepoint) {
+    codepoint = static_cast<char32_t>(*p++);
+    return codepoint <= 0x10FFFF && (codepoint < 0xD800 || codepoint > 0xDFFF);
+  }
+
+  static bool Validate(const char_type* str, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+      char32_t c = static_cast<char32_t>(str[i]);
+      if (c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF))
+        return false;
+    }
+    return true;
+  }
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// Transcoder
+
+//! Convert a character at p from SourceEncoding to TargetEncoding.
+/*! An ill-formed character is replaced by U+FFFD.
+    \returns false if the character is ill-formed.
+ */
+template <typename SourceEncoding, typename TargetEncoding>
+inline bool TranscodeCharacter(const typename SourceEncoding::char_type*& p, const typename SourceEncoding::char_type* end,
+                               typename TargetEncoding::char_type*& dst) {
+  char32_t codepoint;
+  bool valid = SourceEncoding::Decode(p, end, codepoint);
+  dst = TargetEncoding::Encode(dst, valid ? codepoint : 0xFFFD);
+  return valid;
+}
+
+//! Convert UTF-16 to UTF-8, one character at a time.
+/*! \param dst Buffer of at least 3 bytes per unit of the input.
+    @return The pointer past the converted characters.
+ */
+inline char* TranscodeUTF16ToUTF8_Scalar(const char16_t* p, const char16_t* end, char* dst, bool& valid) {
+  while (p != end)
+    valid &= TranscodeCharacter<UTF16<char16_t>, UTF8<char> >(p, end, dst);
+  return dst;
+}
+
+//! Convert UTF-32 to UTF-8, one character at a time.
+/*! \param dst Buffer of at least 4 bytes per unit of the input.
+ */
+inline char* TranscodeUTF32ToUTF8_Scalar(const char32_t* p, const char32_t* end, char* dst, bool& valid) {
+  while (p != end)
+    valid &= TranscodeCharacter<UTF32<char32_t>, UTF8<char> >(p, end, dst);
+  return dst;
+}
+
+#ifdef JSONCXX_SIMD
+//! Shuffles which drop the second byte of the ASCII characters among 8 characters of 2 bytes.
+struct TranscodeCompressTable {
+  TranscodeCompressTable() {
+    for (unsigned mask = 0; mask < 256; ++mask) {
+      unsigned char length = 0;
+      for (unsigned i = 0; i < 8; ++i) {
+        shuffle[mask][length++] = static_cast<unsigned char>(2 * i);
+        if (!(mask & (1u << i)))
+          shuffle[mask][length++] = static_cast<unsigned char>(2 * i + 1);
+      }
+      lengths[mask] = length;
+      for (unsigned i = length; i < 16; ++i)
+        shuffle[mask][i] = 0x80;
+    }
+  }
+
+  unsigned char shuffle[256][16]; //!< Shuffle for each mask of ASCII characters.
+  unsigned char lengths[256];     //!< Number of bytes kept by each shuffle.
+};
+
+//! Get the table of shuffles, which is built on the first call.
+inline const TranscodeCompressTable& GetTranscodeCompressTable() {
+  static const TranscodeCompressTable table;
+  return table;
+}
+
+//! Convert 8 UTF-16 units to UTF-8 at once, if they are all below U+0800 or all 3-byte characters in UTF-8.
+/*! Up to 28 bytes are written at dst, which is moved past the bytes of the characters.
+    @return false if the units mix 3-byte characters with others or have surrogates, in which case nothing is written.
+ */
+JSONCXX_TARGET("sse4.2")
+inline bool TranscodeBlock_SSE42(__m128i u, char*& dst, const TranscodeCompressTable& table) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i mask6 = _mm_set1_epi16(0x3F);
+  const __m128i continuation = _mm_set1_epi16(0x80);
+
+  if (_mm_testz_si128(u, _mm_set1_epi16((short)0xFF80))) { // U+0000 to U+007F
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(u, u));
+    dst += 8;
+    return true;
+  }
+
+  if (_mm_testz_si128(u, _mm_set1_epi16((short)0xF800))) { // below U+0800
+    // 110xxxxx 10xxxxxx in the order of the bytes of each 16-bit unit, or the ASCII character and a byte to drop
+    __m128i b0 = _mm_or_si128(_mm_srli_epi16(u, 6), _mm_set1_epi16(0xC0));
+    __m128i b1 = _mm_or_si128(_mm_and_si128(u, mask6), continuation);
+    __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(u, _mm_set1_epi16((short)0xFF80)), zero);
+    __m128i bytes = _mm_blendv_epi8(_mm_or_si128(b0, _mm_slli_epi16(b1, 8)), u, ascii);
+
+    unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_packs_epi16(ascii, ascii))) & 0xFF;
+    __m128i shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(table.shuffle[mask]));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_shuffle_epi8(bytes, shuffle));
+    dst += table.lengths[mask];
+    return true;
+  }
+
+  __m128i high5 = _mm_and_si128(u, _mm_set1_epi16((short)0xF800));
+  if (_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi16(high5, zero), _mm_cmpeq_epi16(high5, _mm_set1_epi16((short)0xD800)))) != 0)
+    return false; // mixed with 1 or 2-byte characters, or surrogates
+
+  // 1110xxxx 10xxxxxx 10xxxxxx, spread to 32-bit lanes and packed to 12 bytes per 4 units
+  __m128i b0 = _mm_or_si128(_mm_srli_epi16(u, 12), _mm_set1_epi16(0xE0));
+  __m128i b1 = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(u, 6), mask6), continuation);
+  __m128i b2 = _mm_or_si128(_mm_and_si128(u, mask6), continuation);
+  __m128i b01 = _mm_or_si128(b0, _mm_slli_epi16(b1, 8));
+  const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_shuffle_epi8(_mm_unpacklo_epi16(b01, b2), pack));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 12), _mm_shuffle_epi8(_mm_unpackhi_epi16(b01, b2), pack));
+  dst += 24;
+  return true;
+}
+
+//! Convert UTF-16 to UTF-8 with SSE4.2 instructions, 8 units at once.
+/*! \param dst Buffer of at least 3 bytes per unit of the input and 16 more.
+ */
+JSONCXX_TARGET("sse4.2")
+inline char* TranscodeUTF16ToUTF8_SSE42(const char16_t* p, const char16_t* end, char* dst, bool& valid) {
+  const TranscodeCompressTable& table = GetTranscodeCompressTable();
+  while (end - p >= 8) {
+    if (TranscodeBlock_SSE42(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), dst, table))
+      p += 8;
+    else {
+      for (const char16_t* stop = p + 8; p < stop; )
+        valid &= TranscodeCharacter<UTF16<char16_t>, UTF8<char> >(p, end, dst);
+    }
+  }
+  return TranscodeUTF16ToUTF8_Scalar(p, end, dst, valid);
+}
+
+//! Convert UTF-32 to UTF-8 with SSE4.2 instructions, 8 units at once.
+/*! Units of the Basic Multilingual Plane are packed to 16 bits and converted as UTF-16.
+    \param dst Buffer of at least 4 bytes per unit of the input and 16 more.
+ */
+JSONCXX_TARGET("sse4.2")
+inline char* TranscodeUTF32ToUTF8_SSE42(const char32_t* p, const char32_t* end, char* dst, bool& valid) {
+  const TranscodeCompressTable& table = GetTranscodeCompressTable();
+  while (end - p >= 8) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 4));
+    if (_mm_testz_si128(_mm_or_si128(a, b), _mm_set1_epi32((int)0xFFFF0000)) &&
+        TranscodeBlock_SSE42(_mm_packus_epi32(a, b), dst, table))
+      p += 8;
+    else {
+      for (const char32_t* stop = p + 8; p < stop; )
+        valid &= TranscodeCharacter<UTF32<char32_t>, UTF8<char> >(p, end, dst);
+    }
+  }
+  return TranscodeUTF32ToUTF8_Scalar(p, end, dst, valid);
+}
+#endif // JSONCXX_SIMD
+
+//! Converter of characters between encodings.
+/*! Characters are decoded and encoded one at a time. It is specialized for UTF-16 and UTF-32 to UTF-8,
+    which convert blocks of characters with SIMD kernels selected at runtime.
+    \tparam SourceEncoding Encoding of the input.
+    \tparam TargetEncoding Encoding of the output.
+ */
+template <typename SourceEncoding, typename TargetEncoding>
+struct Transcoder {
+  typedef typename SourceEncoding::char_type          source_char_type;
+  typedef typename TargetEncoding::char_type          target_char_type;
+  typedef std::basic_string<target_char_type>         string;
+
+  //! Append converted characters to out. Ill-formed characters are replaced by U+FFFD.
+  /*! @return false if some characters are ill-formed.
+   */
+  static bool Transcode(const source_char_type* str, size_t length, string& out) {
+    const source_char_type* end = str + length;
+    bool valid = true;
+    target_char_type buffer[4];
+    while (str != end) {
+      target_char_type* dst = buffer;
+      valid &= TranscodeCharacter<SourceEncoding, TargetEncoding>(str, end, dst);
+      out.append(buffer, dst);
+    }
+    return valid;
+  }
+};
+
+template <>
+struct Transcoder<UTF16<char16_t>, UTF8<char> > {
+  static bool Transcode(const char16_t* str, size_t length, std::string& out) {
+#ifdef JSONCXX_SIMD
+    static char* (*const kernel)(const char16_t*, const char16_t*, char*, bool&) =
+      GetSimdLevel() >= SimdSSE42 ? &TranscodeUTF16ToUTF8_SSE42 : &TranscodeUTF16ToUTF8_Scalar;
+#else
+    char* (*const kernel)(const char16_t*, const char16_t*, char*, bool&) = &TranscodeUTF16ToUTF8_Scalar;
+#endif
+    size_t size = out.size();
+    out.resize(size + length * 3 + 16);
+    bool valid = true;
+    char* end = kernel(str, str + length, &out[size], valid);
+    out.resize(end - out.data());
+    return valid;
+  }
+};
+
+template <>
+struct Transcoder<UTF32<char32_t>, UTF8<char> > {
+  static bool Transcode(const char32_t* str, size_t length, std::string& out) {
+#ifdef JSONCXX_SIMD
+    static char* (*const kernel)(const char32_t*, const char32_t*, char*, bool&) =
+      GetSimdLevel() >= SimdSSE42 ? &TranscodeUTF32ToUTF8_SSE42 : &TranscodeUTF32ToUTF8_Scalar;
+#else
+    char* (*const kernel)(const char32_t*, const char32_t*, char*, bool&) = &TranscodeUTF32ToUTF8_Scalar;
+#endif
+    size_t size = out.size();
+    out.resize(size + length * 4 + 16);
+    bool valid = true;
+    char* end = kernel(str, str + length, &out[size], valid);
+    out.resize(end - out.data());
+    return valid;
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Encoding detection
+
+//! Unicode encoding schemes of byte input.
+enum UTFType {
+  UTF8Type = 0,   //!< UTF-8.
+  UTF16LEType,    //!< UTF-16 little endian.
+  UTF16BEType,    //!< UTF-16 big endian.
+  UTF32LEType,    //!< UTF-32 little endian.
+  UTF32BEType     //!< UTF-32 big endian.
+};
+
+//! Detect the encoding scheme of bytes from their byte order mark, or from their first characters.
+/*! Without a byte order mark, the encoding is told by the null bytes of the first 4 bytes,
+    since the first two characters of a JSON text are ASCII (RFC 4627).
+    \param data Bytes of the input.
+    \param length Number of bytes.
+    \param bom Set to the number of bytes of the byte order mark, or 0 if there is none.
+ */
+inline UTFType DetectUTF(const char* data, size_t length, size_t& bom) {
+  const unsigned char* b = reinterpret_cast<const unsigned char*>(data);
+  bom = 0;
+
+  if (length >= 4 && b[0] == 0x00 && b[1] == 0x00 && b[2] == 0xFE && b[3] == 0xFF) { bom = 4; return UTF32BEType; }
+  if (length >= 4 && b[0] == 0xFF && b[1] == 0xFE && b[2] == 0x00 && b[3] == 0x00) { bom = 4; return UTF32LEType; }
+  if (length >= 3 && b[0] == 0xEF && b[1] == 0xBB && b[2] == 0xBF) { bom = 3; return UTF8Type; }
+  if (length >= 2 && b[0] == 0xFE && b[1] == 0xFF) { bom = 2; return UTF16BEType; }
+  if (length >= 2 && b[0] == 0xFF && b[1] == 0xFE) { bom = 2; return UTF16LEType; }
+
+  if (length >= 4) {
+    unsigned nulls = (b[0] == 0) | (b[1] == 0) << 1 | (b[2] == 0) << 2 | (b[3] == 0) << 3;
+    switch (nulls) {
+    case 0x7: return UTF32BEType;   // 00 00 00 xx
+    case 0xE: return UTF32LEType;   // xx 00 00 00
+    }
+  }
+  if (length >= 2) {
+    if (b[0] == 0 && b[1] != 0) return UTF16BEType;  // 00 xx
+    if (b[0] != 0 && b[1] == 0) return UTF16LEType;  // xx 00
+  }
+  return UTF8Type;
+}
+
 }
 
 #endif // _JSONCXX_ENCODING_H_
\ No newline at end of file
@@ -0,0 +1,229 @@
+/**
+ *  @file   filestream.hpp
+ *  @brief    Provide file input for reader.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#ifndef _JSONCXX_FILESTREAM_H_
+#define _JSONCXX_FILESTREAM_H_
+
+#include "stream.hpp"
+
+#include <algorithm>    // min
+#include <cstdio>       // FILE, fread
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>      // open
+#include <unistd.h>     // close, sysconf
+#include <sys/mman.h>   // mmap, munmap
+#include <sys/stat.h>   // fstat
+#endif
+
+namespace jsoncxx {
+
+///////////////////////////////////////////////////////////////////////////////
+// MemoryMappedFile
+
+//! Read-only memory-mapped file.
+/*! The contents are mapped straight from the page cache without copying.
+    They are followed by at least JSONCXX_SIMD_PADDING zero bytes, so they are null-terminated
+    and SIMD kernels may load whole blocks past the end of the file.
+
+    Use StringStream over data() to read the file.
+    \tparam Encoding Encoding of the file.
+ */
+template <typename Encoding>
+class MemoryMappedFile {
+ public:
+  typedef typename Encoding::char_type char_type;
+
+  explicit MemoryMappedFile(const char* filename)
+    : data_(0), size_(0), length_(0), mapped_(false) {
+    open(filename);
+  }
+
+  ~MemoryMappedFile() {
+    close();
+  }
+
+  inline bool isOpen() const          { return data_ != 0; }
+
+  //! Get the null-terminated contents of the file.
+  inline const char_type* data() const { return reinterpret_cast<const char_type*>(data_); }
+
+  //! Get the number of characters in the file.
+  inline size_t size() const          { return size_ / sizeof(char_type); }
+
+ private:
+  MemoryMappedFile(const MemoryMappedFile&);
+  MemoryMappedFile& operator= (const MemoryMappedFile&);
+
+#ifdef _WIN32
+  void open(const char* filename) {
+    HANDLE file = ::CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, 0);
+    if (file == INVALID_HANDLE_VALUE)
+      return;
+
+    LARGE_INTEGER size;
+    if (::GetFileSizeEx(file, &size)) {
+      SYSTEM_INFO info;
+      ::GetSystemInfo(&info);
+      size_ = (size_t)size.QuadPart;
+
+      // The rest of the last page is zero-filled, but there may not be enough of it for the padding.
+      size_t rest = size_ % info.dwPageSize;
+      if (rest != 0 && info.dwPageSize - rest >= JSONCXX_SIMD_PADDING) {
+        HANDLE mapping = ::CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+        if (mapping) {
+          data_ = (char*)::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+          mapped_ = data_ != 0;
+          ::CloseHandle(mapping);
+        }
+      } else {
+        length_ = size_ + JSONCXX_SIMD_PADDING;
+        char* buffer = (char*)::VirtualAlloc(0, length_, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        DWORD read = 0;
+        size_t offset = 0;
+        while (buffer && offset < size_ &&
+               ::ReadFile(file, buffer + offset, (DWORD)std::min<size_t>(size_ - offset, 1 << 30), &read, 0) && read > 0)
+          offset += read;
+        if (buffer && offset == size_)
+          data_ = buffer;
+        else if (buffer)
+          ::VirtualFree(buffer, 0, MEM_RELEASE);
+      }
+    }
+
+    ::CloseHandle(file);
+  }
+
+  void close() {
+    if (data_) {
+      if (mapped_)
+        ::UnmapViewOfFile(data_);
+      else
+        ::VirtualFree(data_, 0, MEM_RELEASE);
+    }
+    data_ = 0;
+  }
+#else
+  void open(const char* filename) {
+    int fd = ::open(filename, O_RDONLY);
+    if (fd < 0)
+      return;
+
+    struct stat st;
+    if (::fstat(fd, &st) == 0) {
+      size_t page = (size_t)::sysconf(_SC_PAGESIZE);
+      size_ = (size_t)st.st_size;
+      length_ = (size_ + JSONCXX_SIMD_PADDING + page - 1) / page * page;
+
+      // Reserve zero pages for the file and its padding, then map the file over them.
+      void* base = ::mmap(0, length_, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (base != MAP_FAILED) {
+        if (size_ == 0 ||
+            ::mmap(base, size_, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) != MAP_FAILED) {
+          data_ = (char*)base;
+          mapped_ = true;
+#ifdef MADV_SEQUENTIAL
+          ::madvise(base, length_, MADV_SEQUENTIAL);
+#endif
+        } else
+          ::munmap(base, length_);
+      }
+    }
+
+    ::close(fd);
+  }
+
+  void close() {
+    if (data_)
+      ::munmap(data_, length_);
+    data_ = 0;
+  }
+#endif
+
+  char*   data_;    //!< Contents of the file.
+  size_t  size_;    //!< Size of the file in bytes.
+  size_t  length_;  //!< Size of the mapping including padding in bytes.
+  bool    mapped_;  //!< Whether data_ is a view of the file or a copy of it.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// FileReadStream
+//  Modified by Seonho Oh(seonho.oh@gmail.com)
+//  Original code by
+//    Copyright (c) 2011-2012 Milo Yip (miloyip@gmail.com)
+//
+//! File byte stream for input using a fixed-size refill buffer.
+/*! Memory usage is bounded by the buffer, so it can read files larger than memory and pipes such as stdin.
+    A null character is returned at the end of file.
+    \tparam Encoding Encoding of the file.
+ */
+template <typename Encoding>
+class FileReadStream {
+ public:
+  typedef typename Encoding::char_type char_type;
+
+  //! Constructor.
+  /*! \param fp File pointer opened for read.
+      \param buffer user-supplied buffer, which must outlive the stream.
+      \param bufferSize size of buffer in characters. Must be at least 4.
+   */
+  FileReadStream(std::FILE* fp, char_type* buffer, size_t bufferSize)
+    : fp_(fp), buffer_(buffer), bufferSize_(bufferSize), bufferLast_(0), current_(buffer),
+      readCount_(0), count_(0), eof_(false) {
+    JSONCXX_ASSERT(fp_ != 0);
+    JSONCXX_ASSERT(bufferSize >= 4);
+    read();
+  }
+
+  inline char_type peek() const { return *current_; }
+  inline char_type take() { char_type c = *current_; read(); return c; }
+  inline size_t tell() const { return count_ + (current_ - buffer_); }
+
+  inline char_type* begin() { JSONCXX_ASSERT(false); return 0; }
+  inline void put(char_type) { JSONCXX_ASSERT(false); }
+  inline size_t end(char_type*) { JSONCXX_ASSERT(false); return 0; }
+
+ private:
+  //! Move to the next character, refilling the buffer when it is consumed.
+  void read() {
+    if (current_ < bufferLast_)
+      ++current_;
+    else if (!eof_) {
+      count_ += readCount_;
+      readCount_ = std::fread(buffer_, sizeof(char_type), bufferSize_, fp_);
+      bufferLast_ = buffer_ + readCount_ - 1;
+      current_ = buffer_;
+
+      if (readCount_ < bufferSize_) {
+        buffer_[readCount_] = '\0';
+        ++bufferLast_;
+        eof_ = true;
+      }
+    }
+  }
+
+  std::FILE*  fp_;
+  char_type*  buffer_;
+  size_t      bufferSize_;
+  char_type*  bufferLast_;  //!< Last valid character in the buffer.
+  char_type*  current_;     //!< Current read position.
+  size_t      readCount_;   //!< Number of characters read by the last refill.
+  size_t      count_;       //!< Number of characters read before the buffer.
+  bool        eof_;
+};
+
+}
+
+#endif // _JSONCXX_FILESTREAM_H_
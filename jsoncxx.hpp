@@ -15,7 +15,17 @@
 
 #include "value.hpp"
 #include "stream.hpp"
+#include "filestream.hpp"
 #include "reader.hpp"
+#include "projection.hpp"
+#include "document.hpp"
+#include "pushreader.hpp"
+#include "structural.hpp"
+#include "lazy.hpp"
+#include "tape.hpp"
+#include "parallel.hpp"
+#include "ndjson.hpp"
+#include "binding.hpp"
 #include "writer.hpp"
 
 //! A template-based JSON parser and generator with simple and intuitive interface.
@@ -23,6 +33,7 @@ namespace jsoncxx {
 typedef Value<UTF8<> >                          value;
 typedef Reader<StringStream<UTF8<> >, UTF8<> >  reader;
 typedef Writer<StringStream<UTF8<> >, UTF8<> >  writer;
+typedef Document<UTF8<> >                       document;
 }
 
 #endif // _JSONCXX_H_
\ No newline at end of file
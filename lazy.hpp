@@ -0,0 +1,299 @@
+/**
+ *  @file   lazy.hpp
+ *  @brief    Implement on-demand document which decodes only the values accessed.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#ifndef _JSONCXX_LAZY_H_
+#define _JSONCXX_LAZY_H_
+
+#include "structural.hpp"
+
+#include <iterator>
+
+namespace jsoncxx {
+
+template <typename Encoding> class LazyDocument;
+
+//! Value in a LazyDocument, which is decoded when it is accessed.
+/*! A lazy value is a position in the structural index of its document. Accessing a member or
+    an element walks the tokens of the container and jumps over every value before it without decoding it.
+    Strings, numbers and literals are decoded by Reader when they are read.
+
+    Only the parts of a document which are reached are checked, so errors elsewhere are not reported.
+    A lazy value is valid as long as its document.
+    \tparam Encoding Encoding of the document.
+ */
+template <typename Encoding = UTF8<> >
+class LazyValue {
+ public:
+  typedef typename Encoding::char_type  char_type;
+  typedef std::basic_string<char_type>  string;
+  typedef StringRef<char_type>          string_ref;
+  typedef Value<Encoding>               value_type;
+  typedef LazyValue<Encoding>           self_type;
+  typedef LazyDocument<Encoding>        document_type;
+
+  //! Iterator over the elements of an array or the members of an object.
+  class const_iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef self_type                 value_type;
+    typedef std::ptrdiff_t            difference_type;
+    typedef const self_type*          pointer;
+    typedef self_type                 reference;
+
+    const_iterator() : doc_(0), pos_(0), object_(false) {}
+
+    //! Get the element, or the value of the member.
+    inline self_type operator* () const { return self_type(doc_, object_ ? pos_ + 2 : pos_); }
+
+    //! Get the name of the member.
+    inline string key() const {
+      JSONCXX_ASSERT(object_);
+      return self_type(doc_, pos_).asString();
+    }
+
+    const_iterator& operator++ () {
+      const size_type* p = skip(doc_, object_ ? pos_ + 2 : pos_);
+      char_type c = doc_->json_[*p];
+      if (c == ',')
+        pos_ = p + 1;
+      else if (c == (object_ ? '}' : ']'))
+        pos_ = 0;
+      else if (object_)
+        JSONCXX_PARSING_ERROR("Must be a comma or '}' after an object member");
+      else
+        JSONCXX_PARSING_ERROR("Must be a comma or ']' after an array member");
+
+      if (pos_ && object_)
+        checkMember(doc_, pos_);
+      return *this;
+    }
+
+    inline const_iterator operator++ (int) { const_iterator itr = *this; ++(*this); return itr; }
+
+    inline bool operator == (const const_iterator& other) const { return pos_ == other.pos_; }
+    inline bool operator != (const const_iterator& other) const { return pos_ != other.pos_; }
+
+   private:
+    friend class LazyValue;
+
+    const_iterator(const document_type* doc, const size_type* pos, bool object)
+      : doc_(doc), pos_(pos), object_(object) {}
+
+    const document_type* doc_;
+    const size_type*     pos_;    //!< First token of the element or member, null at the end.
+    bool                 object_;
+  };
+
+  //! Construct a missing value.
+  LazyValue() : doc_(0), pos_(0) {}
+
+  //! Check whether the value is present, which is false for a missing member or element.
+  inline bool exists() const          { return pos_ != 0; }
+
+  //! Get type of value. A missing value is null.
+  ValueType type() const {
+    if (!exists())
+      return NullType;
+
+    switch (head()) {
+    case 'n': return NullType;
+    case 't': return TrueType;
+    case 'f': return FalseType;
+    case '"': return StringType;
+    case '{': return ObjectType;
+    case '[': return ArrayType;
+    default:  return NumberType;
+    }
+  }
+
+  //! @name Property functions.
+  //! @{
+
+  inline bool asBool() const          { return get().asBool(); }
+  inline natural asNatural() const    { return get().asNatural(); }
+  inline real asReal() const          { return get().asReal(); }
+
+  //! Get string value. A string without escape is copied without decoding.
+  string asString() const {
+    JSONCXX_ASSERT(type() == StringType);
+    const char_type* str = doc_->json_ + *pos_ + 1;
+    const char_type* tail = ScanString(str);
+    if (*tail == '"')
+      return string(str, tail);
+    return get().asString().str();
+  }
+
+  //! Decode the value and all of its children.
+  value_type get() const {
+    if (!exists())
+      return value_type();
+
+    StringStream<Encoding> s(doc_->json_ + *pos_);
+    return Reader<StringStream<Encoding>, Encoding>().parse(s);
+  }
+
+  //! Get the number of elements or members, which are skipped without decoding. Other values have none.
+  size_type size() const {
+    size_type count = 0;
+    for (const_iterator itr = begin(); itr != end(); ++itr)
+      ++count;
+    return count;
+  }
+
+  //! @}
+
+  //! @name Container functions.
+  //! @{
+
+  //! Get the first element or member. A missing value or a value which is not a container is empty.
+  const_iterator begin() const {
+    ValueType t = type();
+    if (t != ObjectType && t != ArrayType)
+      return end();
+
+    bool object = t == ObjectType;
+    const size_type* p = pos_ + 1;
+    if (head(p) == (object ? '}' : ']'))
+      return end();
+    if (object)
+      checkMember(doc_, p);
+    return const_iterator(doc_, p, object);
+  }
+
+  inline const_iterator end() const { return const_iterator(doc_, 0, false); }
+
+  //! Access array element by index. Elements before it are skipped.
+  /*! A missing element is returned past the end, or if the value is missing or not an array,
+      so lookups can be chained and checked once with exists().
+   */
+  self_type operator [] (size_type index) const {
+    if (type() != ArrayType)
+      return self_type();
+    for (const_iterator itr = begin(); itr != end(); ++itr, --index)
+      if (index == 0)
+        return *itr;
+    return self_type();
+  }
+
+  //! Access object member by name. Members before it are skipped, and names are compared without decoding unless they have escapes.
+  /*! A missing member is returned if there is none, or if the value is missing or not an object.
+   */
+  self_type operator [] (const string_ref& key) const {
+    if (type() != ObjectType)
+      return self_type();
+    for (const_iterator itr = begin(); itr != end(); ++itr) {
+      const char_type* str = doc_->json_ + *itr.pos_ + 1;
+      const char_type* tail = ScanString(str);
+      if (*tail == '"' ? string_ref(str, (size_type)(tail - str)) == key : itr.key() == key.str())
+        return *itr;
+    }
+    return self_type();
+  }
+
+  //! @}
+
+ private:
+  friend class LazyDocument<Encoding>;
+
+  LazyValue(const document_type* doc, const size_type* pos) : doc_(doc), pos_(pos) {}
+
+  inline char_type head() const { return doc_->json_[*pos_]; }
+  inline char_type head(const size_type* p) const { return doc_->json_[*p]; }
+
+  //! Check that a member starts with a name followed by a colon.
+  static void checkMember(const document_type* doc, const size_type* p) {
+    if (doc->json_[*p] != '"')
+      JSONCXX_PARSING_ERROR("Name of an object member must be a string");
+    if (doc->json_[p[1]] != ':')
+      JSONCXX_PARSING_ERROR("There must be a colon after the name of object member");
+  }
+
+  //! Get the first token after a value, jumping over the tokens of a container by counting brackets.
+  static const size_type* skip(const document_type* doc, const size_type* p) {
+    const char_type* json = doc->json_;
+    switch (json[*p]) {
+    case '{': case '[':
+      break;
+    case '}': case ']': case ':': case ',':
+      JSONCXX_PARSING_ERROR("Invalid value");
+    default:
+      if (p == doc->last())
+        JSONCXX_PARSING_ERROR("Unexpected end of input");
+      return p + 1;
+    }
+
+    const size_type* last = doc->last();
+    for (size_t depth = 1; depth != 0; ) {
+      if (++p == last)
+        JSONCXX_PARSING_ERROR("Unexpected end of input");
+      switch (json[*p]) {
+      case '{': case '[': ++depth; break;
+      case '}': case ']': --depth; break;
+      }
+    }
+    return p + 1;
+  }
+
+  const document_type*  doc_;
+  const size_type*      pos_;   //!< First token of the value, null if missing.
+};
+
+//! On-demand document for reading a few values out of a large document.
+/*! Construction only builds a StructuralIndex of the document, and values are decoded when they are accessed
+    through LazyValue, so the cost of reading a few members is close to the cost of scanning the document.
+
+    @code
+    jsoncxx::MemoryMappedFile<jsoncxx::UTF8<> > file("data.json");
+    jsoncxx::LazyDocument<> doc(file.data(), file.size());
+    jsoncxx::LazyValue<> name = doc.root()["user"]["name"];
+    if (name.type() == jsoncxx::StringType)
+      std::cout << name.asString() << std::endl;
+    @endcode
+
+    The characters of the document are not copied, and must outlive it.
+    \tparam Encoding Encoding of the document. Its character must be a byte.
+ */
+template <typename Encoding = UTF8<> >
+class LazyDocument {
+ public:
+  typedef typename Encoding::char_type  char_type;
+  typedef LazyValue<Encoding>           lazy_value;
+
+  //! Index a document.
+  /*! \param json Characters of the document, which must be followed by a null character.
+      \param length Number of characters.
+   */
+  LazyDocument(const char_type* json, size_t length) : json_(json) {
+    index_.build(json, length);
+  }
+
+  //! Index a null-terminated document.
+  explicit LazyDocument(const char_type* json) : json_(json) {
+    index_.build(json, std::char_traits<char_type>::length(json));
+  }
+
+  //! Get the root value.
+  inline lazy_value root() const { return lazy_value(this, index_.begin()); }
+
+ private:
+  friend class LazyValue<Encoding>;
+
+  LazyDocument(const LazyDocument&);
+  LazyDocument& operator= (const LazyDocument&);
+
+  //! Get the sentinel of the index.
+  inline const size_type* last() const { return index_.end() - 1; }
+
+  const char_type*          json_;
+  StructuralIndex<Encoding> index_;
+};
+
+}
+
+#endif // _JSONCXX_LAZY_H_
@@ -0,0 +1,167 @@
+/**
+ *  @file   ndjson.hpp
+ *  @brief    Implement multithreaded reader for newline-delimited JSON.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#ifndef _JSONCXX_NDJSON_H_
+#define _JSONCXX_NDJSON_H_
+
+#include "reader.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>    // count, find
+#include <iterator>     // back_inserter
+#include <string>
+#include <vector>
+
+namespace jsoncxx {
+
+//! Reader for newline-delimited JSON (NDJSON, JSON Lines), which parses lines on a ThreadPool.
+/*! The input is split into chunks of whole lines, and each chunk is parsed by a thread of the pool.
+    Every line holds one value; lines with only white spaces are skipped.
+    A line which fails to parse is reported with its error, and the rest of the input is still parsed.
+    Each line is parsed up to its end only, with nesting limited to JSONCXX_MAX_DEPTH, so the cost of a
+    broken line is bounded by its own length.
+
+    @code
+    jsoncxx::MemoryMappedFile<jsoncxx::UTF8<> > file("log.ndjson");
+    jsoncxx::NdjsonReader<> reader;
+    std::vector<jsoncxx::NdjsonReader<>::Record> records = reader.parse(file.data(), file.size());
+    @endcode
+
+    \tparam Encoding Encoding of the input.
+ */
+template <typename Encoding = UTF8<> >
+class NdjsonReader {
+ public:
+  typedef typename Encoding::char_type  char_type;
+  typedef Value<Encoding>               value_type;
+
+  //! Result of a line.
+  struct Record {
+    Record() : line(0) {}
+
+    inline bool ok() const { return error.empty(); }
+
+    size_t      line;   //!< Line number, starting from 1.
+    value_type  value;  //!< Parsed value, null on error.
+    std::string error;  //!< Message of the parsing error, empty on success.
+  };
+
+  //! Constructor.
+  /*! \param pool Threads to parse on.
+      \param chunkSize Approximate number of characters parsed by a task.
+   */
+  explicit NdjsonReader(ThreadPool& pool = DefaultThreadPool(), size_t chunkSize = 1 << 20)
+    : pool_(pool), chunkSize_(chunkSize > 0 ? chunkSize : 1) {}
+
+  //! Parse all lines and return their records in order.
+  /*! \param data Characters of the input, which must be followed by a null character.
+      \param length Number of characters.
+   */
+  std::vector<Record> parse(const char_type* data, size_t length) {
+    std::vector<std::vector<Record> > chunks;
+    parseChunks(data, length, [&chunks](size_t chunk, Record& record) {
+      chunks[chunk].push_back(std::move(record));
+    }, [&chunks](size_t count) { chunks.resize(count); });
+
+    size_t total = 0;
+    for (size_t i = 0; i < chunks.size(); ++i)
+      total += chunks[i].size();
+
+    std::vector<Record> records;
+    records.reserve(total);
+    for (size_t i = 0; i < chunks.size(); ++i)
+      std::move(chunks[i].begin(), chunks[i].end(), std::back_inserter(records));
+    return records;
+  }
+
+  //! Parse all lines and pass each record to callback.
+  /*! The callback is called as callback(Record&) from the threads of the pool at the same time,
+      in order of lines within a chunk but in no order across chunks, so it must be thread-safe.
+   */
+  template <typename Callback>
+  void parse(const char_type* data, size_t length, Callback callback) {
+    parseChunks(data, length, [&callback](size_t, Record& record) { callback(record); }, [](size_t) {});
+  }
+
+ private:
+  //! Split the input at line ends, then parse chunks in parallel.
+  /*! \param emit Called with the chunk index and each record.
+      \param prepare Called with the number of chunks before parsing.
+   */
+  template <typename Emit, typename Prepare>
+  void parseChunks(const char_type* data, size_t length, Emit emit, Prepare prepare) {
+    std::vector<const char_type*> bounds(1, data);
+    const char_type* end = data + length;
+    while (bounds.back() != end) {
+      const char_type* p = bounds.back() + std::min(chunkSize_, (size_t)(end - bounds.back()));
+      while (p != end && *(p - 1) != '\n')
+        ++p;
+      bounds.push_back(p);
+    }
+
+    // Line numbers of chunks, counted in parallel.
+    size_t count = bounds.size() - 1;
+    std::vector<size_t> lines(count + 1, 1);
+    pool_.parallelFor(count, [&](size_t i) {
+      lines[i + 1] = std::count(bounds[i], bounds[i + 1], '\n');
+    });
+    for (size_t i = 1; i <= count; ++i)
+      lines[i] += lines[i - 1];
+
+    prepare(count);
+    pool_.parallelFor(count, [&](size_t i) {
+      parseChunk(bounds[i], bounds[i + 1], lines[i], [&emit, i](Record& record) { emit(i, record); });
+    });
+  }
+
+  //! Parse the lines of a chunk.
+  /*! Each line is copied into a buffer terminated after it, so a broken value never reads into the
+      following lines, and it is parsed iteratively, so nesting deeper than JSONCXX_MAX_DEPTH is an error.
+   */
+  template <typename Emit>
+  static void parseChunk(const char_type* head, const char_type* tail, size_t line, Emit emit) {
+    Reader<StringStream<Encoding>, Encoding> reader;
+    std::basic_string<char_type> buffer;
+
+    for (const char_type* p = head; p != tail; ++line) {
+      const char_type* next = std::find(p, tail, '\n');
+      const char_type* first = p;
+      while (first != next && IsWhitespace(*first))
+        ++first;
+
+      if (first != next) {
+        buffer.assign(first, next);
+        StringStream<Encoding> s(buffer.c_str());
+
+        Record record;
+        record.line = line;
+        ParseResult result = reader.template tryParse<ParseIterativeFlag>(s, record.value);
+        if (result) {
+          SkipWhitespace(s);
+          if (s.tell() != buffer.size())
+            result = ParseResult(ParseErrorDocumentRootNotSingular, s.tell());
+        }
+        if (!result) {
+          record.value = value_type();
+          record.error = result.message();
+        }
+        emit(record);
+      }
+
+      p = next == tail ? tail : next + 1;
+    }
+  }
+
+  ThreadPool& pool_;
+  size_t      chunkSize_;
+};
+
+}
+
+#endif // _JSONCXX_NDJSON_H_
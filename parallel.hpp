@@ -0,0 +1,268 @@
+/**
+ *  @file   parallel.hpp
+ *  @brief    Implement worker pool and readers parsing in parallel.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#ifndef _JSONCXX_PARALLEL_H_
+#define _JSONCXX_PARALLEL_H_
+
+#include "reader.hpp"
+#include "structural.hpp"
+
+#include <algorithm>    // min, max
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>    // exception_ptr
+#include <functional>
+#include <memory>       // shared_ptr
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace jsoncxx {
+
+//! Fixed pool of worker threads.
+/*! The calling thread takes part in every parallelFor(), so a pool of n threads starts n - 1 workers.
+ */
+class ThreadPool {
+ public:
+  //! Start workers.
+  /*! \param threads Number of threads including the caller, or 0 for the number of hardware threads.
+   */
+  explicit ThreadPool(size_t threads = 0) : stop_(false) {
+    if (threads == 0)
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 1; i < threads; ++i)
+      workers_.emplace_back([this] { run(); });
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    ready_.notify_all();
+    for (size_t i = 0; i < workers_.size(); ++i)
+      workers_[i].join();
+  }
+
+  //! Get the number of threads including the caller.
+  inline size_t size() const { return workers_.size() + 1; }
+
+  //! Call fn(i) for every i in [0, count) on the workers and the calling thread, and wait for all calls.
+  /*! Indices are taken one at a time, so uneven tasks are balanced.
+      If a call throws, the remaining indices are still run and the first exception is rethrown.
+      It may be called from inside a task; the caller then runs what no idle worker picks up.
+   */
+  template <typename Function>
+  void parallelFor(size_t count, Function fn) {
+    std::shared_ptr<Batch> batch = std::make_shared<Batch>(count);
+
+    size_t helpers = std::min(workers_.size(), count > 0 ? count - 1 : 0);
+    if (helpers > 0) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < helpers; ++i)
+          tasks_.push_back([batch, &fn] {
+            if (batch->join()) {
+              batch->run(fn);
+              batch->leave();
+            }
+          });
+      }
+      ready_.notify_all();
+    }
+
+    batch->run(fn);
+    batch->close();
+    if (batch->error_)
+      std::rethrow_exception(batch->error_);
+  }
+
+ private:
+  ThreadPool(const ThreadPool&);
+  ThreadPool& operator= (const ThreadPool&);
+
+  //! Indices of a parallelFor() shared by the threads working on it.
+  struct Batch {
+    explicit Batch(size_t count) : next_(0), count_(count), active_(0), closed_(false) {}
+
+    template <typename Function>
+    void run(Function& fn) {
+      for (size_t i; (i = next_++) < count_; ) {
+        try {
+          fn(i);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(mutex_);
+          if (!error_)
+            error_ = std::current_exception();
+        }
+      }
+    }
+
+    //! Register a worker, unless the caller has already finished and stopped waiting for help.
+    bool join() {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (closed_)
+        return false;
+      ++active_;
+      return true;
+    }
+
+    void leave() {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--active_ == 0)
+        done_.notify_all();
+    }
+
+    //! Stop accepting workers and wait for those working.
+    void close() {
+      std::unique_lock<std::mutex> lock(mutex_);
+      closed_ = true;
+      done_.wait(lock, [this] { return active_ == 0; });
+    }
+
+    std::atomic<size_t>     next_;
+    size_t                  count_;
+    size_t                  active_;  //!< Workers which joined and have not finished.
+    bool                    closed_;
+    std::exception_ptr      error_;   //!< First exception thrown by a call.
+    std::mutex              mutex_;
+    std::condition_variable done_;
+  };
+
+  void run() {
+    for (;;) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+        if (tasks_.empty())
+          return;
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::vector<std::thread>          workers_;
+  std::deque<std::function<void()> > tasks_;
+  std::mutex                        mutex_;
+  std::condition_variable           ready_;
+  bool                              stop_;
+};
+
+//! Get the pool shared by parallel readers, which has a thread per hardware thread.
+inline ThreadPool& DefaultThreadPool() {
+  static ThreadPool pool;
+  return pool;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ParallelArrayReader
+
+//! Reader for a document whose root is a large array, which parses its elements on a ThreadPool.
+/*! The boundaries of the top-level elements are found with a StructuralIndex, so commas in strings and
+    nested values are ignored. Consecutive elements are grouped into tasks, each parsed by Reader into
+    its own values, which are then moved into the resulting array without copying.
+
+    A root which is not an array is parsed by Reader on the calling thread.
+
+    @code
+    jsoncxx::MemoryMappedFile<jsoncxx::UTF8<> > file("records.json");
+    jsoncxx::value records = jsoncxx::ParallelArrayReader<>().parse(file.data(), file.size());
+    @endcode
+
+    \tparam Encoding Encoding of the document. Its character must be a byte.
+ */
+template <typename Encoding = UTF8<> >
+class ParallelArrayReader {
+ public:
+  typedef typename Encoding::char_type  char_type;
+  typedef Value<Encoding>               value_type;
+
+  //! Constructor.
+  /*! \param pool Threads to parse on.
+      \param tasksPerThread Number of groups of elements per thread, for balancing uneven elements.
+   */
+  explicit ParallelArrayReader(ThreadPool& pool = DefaultThreadPool(), size_t tasksPerThread = 8)
+    : pool_(pool), tasksPerThread_(tasksPerThread > 0 ? tasksPerThread : 1) {}
+
+  //! Parse a document.
+  /*! \param json Characters of the document, which must be followed by a null character.
+      \param length Number of characters.
+   */
+  value_type parse(const char_type* json, size_t length) {
+    index_.build(json, length);
+    const size_type* first = index_.begin();
+    const size_type* last = index_.end() - 1;  // sentinel
+
+    if (json[*first] != '[') {
+      StringStream<Encoding> s(json);
+      return Reader<StringStream<Encoding>, Encoding>().parse(s);
+    }
+
+    // Positions of the opening bracket, the commas between elements and the closing bracket.
+    std::vector<size_type> bounds(1, *first);
+    const size_type* p = first + 1;
+    for (size_t depth = 1; ; ++p) {
+      if (p == last)
+        JSONCXX_PARSING_ERROR("Must be a comma or ']' after an array member");
+      char_type c = json[*p];
+      if (c == '{' || c == '[')
+        ++depth;
+      else if (c == '}' || c == ']') {
+        if (--depth == 0)
+          break;
+      } else if (c == ',' && depth == 1)
+        bounds.push_back(*p);
+    }
+    if (json[*p] != ']')
+      JSONCXX_PARSING_ERROR("Must be a comma or ']' after an array member");
+    bounds.push_back(*p);
+    if (p + 1 != last)
+      JSONCXX_PARSING_ERROR("The document root must not be followed by other values");
+
+    size_t count = json[*(first + 1)] == ']' ? 0 : bounds.size() - 1;
+    size_t tasks = std::min(count, pool_.size() * tasksPerThread_);
+    std::vector<std::vector<value_type> > groups(tasks);
+
+    pool_.parallelFor(tasks, [&](size_t task) {
+      Reader<StringStream<Encoding>, Encoding> reader;
+      size_t begin = count * task / tasks, end = count * (task + 1) / tasks;
+      std::vector<value_type>& group = groups[task];
+      group.reserve(end - begin);
+
+      for (size_t i = begin; i < end; ++i) {
+        StringStream<Encoding> s(json + bounds[i] + 1);
+        group.push_back(reader.parse(s));
+        SkipWhitespace(s);
+        if (bounds[i] + 1 + s.tell() != bounds[i + 1])
+          JSONCXX_PARSING_ERROR("Must be a comma or ']' after an array member");
+      }
+    });
+
+    value_type array(ArrayType);
+    array.reserve(count);
+    for (size_t i = 0; i < tasks; ++i)
+      for (size_t j = 0; j < groups[i].size(); ++j)
+        array.append(std::move(groups[i][j]));
+    return array;
+  }
+
+ private:
+  ThreadPool&               pool_;
+  size_t                    tasksPerThread_;
+  StructuralIndex<Encoding> index_;
+};
+
+}
+
+#endif // _JSONCXX_PARALLEL_H_
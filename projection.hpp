@@ -0,0 +1,141 @@
+/**
+ *  @file   projection.hpp
+ *  @brief    Implement set of JSON Pointer paths selecting the values to parse.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#ifndef _JSONCXX_PROJECTION_H_
+#define _JSONCXX_PROJECTION_H_
+
+#include "reader.hpp"
+
+#include <algorithm>    // lower_bound
+#include <initializer_list>
+#include <string>
+#include <utility>      // pair
+#include <vector>
+
+namespace jsoncxx {
+
+//! Set of JSON Pointer (RFC 6901) paths, which selects the values Reader::project() materializes.
+/*! The paths are kept in a tree of their reference tokens. A token of digits without leading zeros
+    selects an element of an array as well as a member of an object.
+
+    @code
+    jsoncxx::Projection<> projection({ "/user/name", "/tags/0" });
+    jsoncxx::StringStream<jsoncxx::UTF8<> > s(json);
+    jsoncxx::value event = jsoncxx::reader().project(s, projection);
+    @endcode
+
+    \tparam Encoding Encoding of the paths and of the documents.
+ */
+template <typename Encoding = UTF8<> >
+class Projection {
+ public:
+  typedef typename Encoding::char_type  char_type;
+  typedef std::basic_string<char_type>  string;
+
+  //! Construct an empty projection, which selects nothing but the root container.
+  Projection() : nodes_(1) {}
+
+  //! Construct a projection of paths.
+  Projection(std::initializer_list<string> pointers) : nodes_(1) {
+    for (const string& pointer : pointers)
+      add(pointer);
+  }
+
+  //! Add a path. The empty pointer selects the whole document.
+  void add(const string& pointer) {
+    if (!pointer.empty() && pointer[0] != '/')
+      JSONCXX_PARSING_ERROR("JSON pointer must start with '/'");
+
+    size_t node = 0;
+    for (size_t pos = 0; pos < pointer.size() && !nodes_[node].whole_; ) {
+      size_t next = pointer.find('/', pos + 1);
+      if (next == string::npos)
+        next = pointer.size();
+      node = child(node, unescape(pointer.substr(pos + 1, next - pos - 1)));
+      pos = next;
+    }
+
+    // Paths below are covered by this one.
+    nodes_[node].whole_ = true;
+    nodes_[node].members_.clear();
+    nodes_[node].elements_.clear();
+  }
+
+ private:
+  template <typename, typename> friend class Reader;
+
+  //! Node of the tree, which is a value on some of the paths.
+  struct Node {
+    Node() : whole_(false) {}
+
+    bool                                    whole_;     //!< Whether the value is at the end of a path and parsed with all of its children.
+    std::vector<std::pair<string, size_t> > members_;   //!< Tokens and nodes of children.
+    std::vector<std::pair<size_type, size_t> > elements_; //!< Indices and nodes of children whose token is an array index, sorted by index.
+  };
+
+  typedef typename std::vector<std::pair<size_type, size_t> >::const_iterator element_iterator;
+
+  //! Decode ~1 and ~0 in a reference token.
+  static string unescape(const string& token) {
+    string decoded;
+    for (size_t i = 0; i < token.size(); ++i) {
+      if (token[i] != '~')
+        decoded += token[i];
+      else if (i + 1 < token.size() && (token[i + 1] == '0' || token[i + 1] == '1'))
+        decoded += token[++i] == '0' ? '~' : '/';
+      else
+        JSONCXX_PARSING_ERROR("Invalid escape in JSON pointer");
+    }
+    return decoded;
+  }
+
+  //! Get the child of a node for a token, adding it if missing.
+  size_t child(size_t node, const string& token) {
+    for (size_t i = 0; i < nodes_[node].members_.size(); ++i)
+      if (nodes_[node].members_[i].first == token)
+        return nodes_[node].members_[i].second;
+
+    size_t added = nodes_.size();
+    nodes_.push_back(Node());
+    nodes_[node].members_.push_back(std::make_pair(token, added));
+
+    bool index = !token.empty() && token.size() <= 9 && (token[0] != '0' || token.size() == 1);
+    for (size_t i = 0; index && i < token.size(); ++i)
+      index = token[i] >= '0' && token[i] <= '9';
+    if (index) {
+      size_type n = 0;
+      for (size_t i = 0; i < token.size(); ++i)
+        n = n * 10 + (token[i] - '0');
+      std::vector<std::pair<size_type, size_t> >& elements = nodes_[node].elements_;
+      elements.insert(std::lower_bound(elements.begin(), elements.end(), std::make_pair(n, added)), std::make_pair(n, added));
+    }
+    return added;
+  }
+
+  //! Check whether the value of a node is parsed with all of its children.
+  inline bool whole(size_t node) const { return nodes_[node].whole_; }
+
+  //! Get the child of a node for the name of a member, or 0 if it is not selected.
+  size_t member(size_t node, const char_type* str, size_type length) const {
+    const std::vector<std::pair<string, size_t> >& members = nodes_[node].members_;
+    for (size_t i = 0; i < members.size(); ++i)
+      if (members[i].first.size() == length && members[i].first.compare(0, length, str, length) == 0)
+        return members[i].second;
+    return 0;
+  }
+
+  inline element_iterator elementsBegin(size_t node) const { return nodes_[node].elements_.begin(); }
+  inline element_iterator elementsEnd(size_t node) const   { return nodes_[node].elements_.end(); }
+
+  std::vector<Node> nodes_; //!< Nodes of the tree, whose root is the first one.
+};
+
+}
+
+#endif // _JSONCXX_PROJECTION_H_
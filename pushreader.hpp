@@ -0,0 +1,285 @@
+/**
+ *  @file   pushreader.hpp
+ *  @brief    Implement resumable push reader class.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#ifndef _JSONCXX_PUSHREADER_H_
+#define _JSONCXX_PUSHREADER_H_
+
+#include "reader.hpp"
+
+#include <vector>
+
+namespace jsoncxx {
+
+//! Push reader which parses a document arriving in arbitrary fragments.
+/*! Input is given through feed() as it arrives; parsing suspends in the middle of a token
+    when a fragment runs out and resumes with the next one. Events are reported to the handler
+    as soon as each value is complete, and finish() signals the end of input.
+
+    Only tokens which straddle fragments are copied; every other token is parsed in place.
+
+    @code
+    jsoncxx::ValueHandler<> handler;
+    jsoncxx::PushReader<jsoncxx::ValueHandler<> > reader(handler);
+    while (size_t n = receive(buffer, sizeof(buffer)))
+        reader.feed(buffer, n);
+    reader.finish();
+    jsoncxx::value root = handler.release();
+    @endcode
+
+    \tparam Handler Handler receiving events, see Handler concept.
+    \tparam Encoding Encoding of the input.
+ */
+template <typename Handler, typename Encoding = UTF8<> >
+class PushReader {
+ public:
+  typedef typename Encoding::char_type  char_type;
+
+  explicit PushReader(Handler& handler)
+    : handler_(handler), state_(ExpectValue), token_(NoToken), escape_(false) {}
+
+  //! Parse the next fragment of input.
+  /*! \param data Characters of the fragment, which need not be null-terminated.
+      \param length Number of characters.
+   */
+  void feed(const char_type* data, size_t length) {
+    const char_type* p = data;
+    const char_type* end = data + length;
+
+    if (token_ != NoToken)
+      p = resumeToken(p, end);
+
+    while (p != end) {
+      switch (*p) {
+      case ' ': case '\n': case '\r': case '\t':
+        ++p;
+        break;
+      case '{':
+        expectValue();
+        handler_.startObject();
+        stack_.push_back(Frame(true));
+        state_ = ExpectFirstMember;
+        ++p;
+        break;
+      case '[':
+        expectValue();
+        handler_.startArray();
+        stack_.push_back(Frame(false));
+        state_ = ExpectFirstElement;
+        ++p;
+        break;
+      case '}':
+        if (state_ != ExpectFirstMember && !(state_ == ExpectSeparator && stack_.back().object_))
+          JSONCXX_PARSING_ERROR("Must be a comma or '}' after an object member");
+        endContainer();
+        ++p;
+        break;
+      case ']':
+        if (state_ != ExpectFirstElement && !(state_ == ExpectSeparator && !stack_.back().object_))
+          JSONCXX_PARSING_ERROR("Must be a comma or ']' after an array member");
+        endContainer();
+        ++p;
+        break;
+      case ',':
+        if (state_ != ExpectSeparator)
+          JSONCXX_PARSING_ERROR("Unexpected comma");
+        state_ = stack_.back().object_ ? ExpectMember : ExpectValue;
+        ++p;
+        break;
+      case ':':
+        if (state_ != ExpectColon)
+          JSONCXX_PARSING_ERROR("Unexpected colon");
+        state_ = ExpectValue;
+        ++p;
+        break;
+      case '"':
+        if (state_ == ExpectFirstMember || state_ == ExpectMember)
+          token_ = KeyToken;
+        else {
+          expectValue();
+          token_ = StringToken;
+        }
+        p = scanString(p, p + 1, end);
+        break;
+      default:
+        if (state_ == ExpectFirstMember || state_ == ExpectMember)
+          JSONCXX_PARSING_ERROR("Name of an object member must be a string");
+        expectValue();
+        token_ = BareToken;
+        p = scanBare(p, p, end);
+      }
+    }
+  }
+
+  //! Signal the end of input.
+  void finish() {
+    if (token_ == BareToken)
+      completeToken(buffer_);
+    else if (token_ != NoToken)
+      JSONCXX_PARSING_ERROR("Lacks ending quation before the the end of string");
+
+    if (state_ != Done)
+      JSONCXX_PARSING_ERROR("Unexpected end of input");
+  }
+
+  //! Check whether a complete document has been parsed.
+  inline bool isDone() const { return state_ == Done && token_ == NoToken; }
+
+  //! Prepare to parse a new document.
+  void reset() {
+    stack_.clear();
+    buffer_.clear();
+    state_ = ExpectValue;
+    token_ = NoToken;
+    escape_ = false;
+  }
+
+ private:
+  //! What is allowed at the current position, outside of tokens.
+  enum State {
+    ExpectValue,        //!< A value (root, after colon or after comma in array).
+    ExpectFirstElement, //!< A value or ']'.
+    ExpectFirstMember,  //!< A name or '}'.
+    ExpectMember,       //!< A name.
+    ExpectColon,        //!< ':' after a name.
+    ExpectSeparator,    //!< ',' or the end of the container.
+    Done,               //!< Only white spaces after the root value.
+  };
+
+  //! Kind of the token being scanned.
+  enum Token {
+    NoToken,
+    StringToken,
+    KeyToken,
+    BareToken,          //!< Number or literal.
+  };
+
+  //! Container being parsed.
+  struct Frame {
+    explicit Frame(bool object) : object_(object), count_(0) {}
+
+    bool      object_;
+    size_type count_;
+  };
+
+  void expectValue() {
+    if (state_ == Done)
+      JSONCXX_PARSING_ERROR("The document root must not be followed by other values");
+    if (state_ != ExpectValue && state_ != ExpectFirstElement)
+      JSONCXX_PARSING_ERROR("Invalid value");
+  }
+
+  //! Update state after a complete value.
+  void endValue() {
+    if (stack_.empty())
+      state_ = Done;
+    else {
+      ++stack_.back().count_;
+      state_ = ExpectSeparator;
+    }
+  }
+
+  void endContainer() {
+    Frame frame = stack_.back();
+    stack_.pop_back();
+    if (frame.object_)
+      handler_.endObject(frame.count_);
+    else
+      handler_.endArray(frame.count_);
+    endValue();
+  }
+
+  //! Continue the token left incomplete by the previous fragment.
+  const char_type* resumeToken(const char_type* p, const char_type* end) {
+    if (token_ == BareToken)
+      return scanBare(p, p, end);
+    return scanString(p, p, end);
+  }
+
+  //! Find the closing quotation mark of a string.
+  /*! \param head First character of the token in this fragment.
+      \param p Position to continue scanning.
+   */
+  const char_type* scanString(const char_type* head, const char_type* p, const char_type* end) {
+    for (; p != end; ++p) {
+      if (escape_)
+        escape_ = false;
+      else if (*p == '\\')
+        escape_ = true;
+      else if (*p == '"')
+        return endToken(head, p + 1);
+    }
+    return suspendToken(head, end);
+  }
+
+  //! Find the end of a number or literal.
+  const char_type* scanBare(const char_type* head, const char_type* p, const char_type* end) {
+    for (; p != end; ++p) {
+      switch (*p) {
+      case ' ': case '\n': case '\r': case '\t':
+      case ',': case ':': case '[': case ']': case '{': case '}': case '"':
+        return endToken(head, p);
+      }
+    }
+    return suspendToken(head, end);
+  }
+
+  //! Keep the part of token in this fragment until the next one.
+  const char_type* suspendToken(const char_type* head, const char_type* end) {
+    buffer_.insert(buffer_.end(), head, end);
+    return end;
+  }
+
+  //! Parse a token ending right before tail.
+  const char_type* endToken(const char_type* head, const char_type* tail) {
+    if (buffer_.empty()) {
+      // Whole token in this fragment. It is followed by a delimiter, so reader stops before the end.
+      completeToken(head, tail - head);
+    } else {
+      buffer_.insert(buffer_.end(), head, tail);
+      completeToken(buffer_);
+    }
+    return tail;
+  }
+
+  void completeToken(std::vector<char_type>& buffer) {
+    buffer.push_back('\0');
+    completeToken(buffer.data(), buffer.size() - 1);
+    buffer.clear();
+  }
+
+  //! Parse a complete token with reader.
+  void completeToken(const char_type* token, size_t length) {
+    StringStream<Encoding> s(token);
+    Token kind = token_;
+    token_ = NoToken;
+
+    if (kind == KeyToken) {
+      KeyHandler<Handler, Encoding> handler(handler_);
+      reader_.parse(s, handler);
+      state_ = ExpectColon;
+    } else {
+      reader_.parse(s, handler_);
+      if (s.tell() != length)
+        JSONCXX_PARSING_ERROR("Invalid value");
+      endValue();
+    }
+  }
+
+  Handler&                                handler_;
+  Reader<StringStream<Encoding>, Encoding> reader_;   //!< Reader parsing complete tokens.
+  std::vector<Frame>                      stack_;     //!< Containers being parsed.
+  std::vector<char_type>                  buffer_;    //!< Part of the token received so far.
+  State                                   state_;
+  Token                                   token_;
+  bool                                    escape_;    //!< Whether the last character of a string was a backslash.
+};
+
+}
+
+#endif // _JSONCXX_PUSHREADER_H_
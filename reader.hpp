@@ -12,106 +12,410 @@
 
 #include "encoding.hpp"
 #include "value.hpp"
+#include "stream.hpp"
+#include "filestream.hpp"
+#include "simd.hpp"
 
 #include <stdexcept>    // runtime_error
 #include <sstream>      // stringstream
 #include <string>       // basic_stream
 #include <fstream>      // basic_ifstream
+#include <cstdlib>      // strtod
+#include <cstdio>       // snprintf
+#include <cmath>        // HUGE_VAL
+#include <clocale>      // LC_NUMERIC
+#if defined(__APPLE__) || defined(__FreeBSD__)
+#include <xlocale.h>    // strtod_l
+#endif
+
+#ifndef JSONCXX_MAX_DIGITS
+//! Maximum number of significant digits of a number kept for conversion.
+/*! 768 digits are enough to round any decimal number to double correctly.
+ */
+#define JSONCXX_MAX_DIGITS 768
+#endif
+
+#ifndef JSONCXX_MAX_DEPTH
+//! Default maximum nesting of arrays and objects.
+#define JSONCXX_MAX_DEPTH 1024
+#endif
 
 namespace jsoncxx {
 
+//! Round a pointer up to a multiple of width, which is a power of two.
+template <typename CharType>
+inline const CharType* AlignUp(const CharType* p, size_t width) {
+  return reinterpret_cast<const CharType*>((reinterpret_cast<size_t>(p) + width - 1) & ~(width - 1));
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // SkipWhitespace
 // Copyright (c) 2011 Milo Yip (miloyip@gmail.com)
 // Version 0.1
 
+//! Check whether a character is a JSON white space.
+template <typename CharType>
+inline bool IsWhitespace(CharType c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
 //! Skip the JSON white spaces in a stream.
 /*! \param stream A input stream for skipping white spaces.
- \note This function has SSE2/SSE4.2 specialization.
+ \note This function has specializations for string streams of char, which dispatch to SIMD kernels at runtime.
  */
 template<typename Stream>
 void SkipWhitespace(Stream& stream) {
   Stream s = stream;  // Use a local copy for optimization
-  while (s.peek() == ' ' || s.peek() == '\n' || s.peek() == '\r' || s.peek() == '\t')
+  while (IsWhitespace(s.peek()))
     s.take();
   stream = s;
 }
 
-#ifdef JSONCXX_SSE42
+//! Skip whitespace one character at a time.
+inline const char* SkipWhitespace_Scalar(const char* p) {
+  while (IsWhitespace(*p))
+    ++p;
+  return p;
+}
+
+#ifdef JSONCXX_SIMD
+// The kernels below skip characters one by one up to an aligned block, then test whole aligned blocks.
+// An aligned block never crosses a page boundary, so reading past the null terminator is safe
+// and strings need no padding.
+
+//! Skip whitespace with SSE2 instructions, testing 16 8-byte characters at once.
+JSONCXX_NO_SANITIZE_ADDRESS JSONCXX_TARGET("sse2")
+inline const char* SkipWhitespace_SSE2(const char* p) {
+  for (const char* aligned = AlignUp(p, 16); p != aligned; ++p)
+    if (!IsWhitespace(*p))
+      return p;
+
+  const __m128i w0 = _mm_set1_epi8(' ');
+  const __m128i w1 = _mm_set1_epi8('\n');
+  const __m128i w2 = _mm_set1_epi8('\r');
+  const __m128i w3 = _mm_set1_epi8('\t');
+
+  for (;; p += 16) {
+    __m128i s = _mm_load_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i x = _mm_cmpeq_epi8(s, w0);
+    x = _mm_or_si128(x, _mm_cmpeq_epi8(s, w1));
+    x = _mm_or_si128(x, _mm_cmpeq_epi8(s, w2));
+    x = _mm_or_si128(x, _mm_cmpeq_epi8(s, w3));
+    unsigned r = ~static_cast<unsigned>(_mm_movemask_epi8(x)) & 0xFFFF;
+    if (r != 0) // some of characters are non-whitespace
+      return p + CountTrailingZeros(r);
+  }
+}
+
 //! Skip whitespace with SSE 4.2 pcmpistrm instruction, testing 16 8-byte characters at once.
-inline const char *SkipWhitespace_SIMD(const char* p) {
+JSONCXX_NO_SANITIZE_ADDRESS JSONCXX_TARGET("sse4.2")
+inline const char* SkipWhitespace_SSE42(const char* p) {
+  for (const char* aligned = AlignUp(p, 16); p != aligned; ++p)
+    if (!IsWhitespace(*p))
+      return p;
+
   static const char whitespace[16] = " \n\r\t";
-  __m128i w = _mm_loadu_si128((const __m128i *)&whitespace[0]);
+  const __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&whitespace[0]));
+
+  for (;; p += 16) {
+    // Characters from the null terminator on are reported as non-whitespace.
+    __m128i s = _mm_load_si128(reinterpret_cast<const __m128i *>(p));
+    unsigned r = static_cast<unsigned>(_mm_cvtsi128_si32(_mm_cmpistrm(w, s, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK | _SIDD_NEGATIVE_POLARITY)));
+    if (r != 0) // some of characters are non-whitespace
+      return p + CountTrailingZeros(r);
+  }
+}
 
-  for (;;) {
-    __m128i s = _mm_loadu_si128((const __m128i *)p);
-    unsigned r = _mm_cvtsi128_si32(_mm_cmpistrm(w, s, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK | _SIDD_NEGATIVE_POLARITY));
-    if (r == 0) // all 16 characters are whitespace
-      p += 16;
-    else {    // some of characters may be non-whitespace
-#ifdef _MSC_VER   // Find the index of first non-whitespace
-      unsigned long offset;
-      if (_BitScanForward(&offset, r))
-        return p + offset;
-#else
-      if (r != 0)
-        return p + __builtin_ffs(r) - 1;
+//! Skip whitespace with AVX2 instructions, testing 32 8-byte characters at once.
+JSONCXX_NO_SANITIZE_ADDRESS JSONCXX_TARGET("avx2")
+inline const char* SkipWhitespace_AVX2(const char* p) {
+  for (const char* aligned = AlignUp(p, 32); p != aligned; ++p)
+    if (!IsWhitespace(*p))
+      return p;
+
+  const __m256i w0 = _mm256_set1_epi8(' ');
+  const __m256i w1 = _mm256_set1_epi8('\n');
+  const __m256i w2 = _mm256_set1_epi8('\r');
+  const __m256i w3 = _mm256_set1_epi8('\t');
+
+  for (;; p += 32) {
+    __m256i s = _mm256_load_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i x = _mm256_or_si256(_mm256_cmpeq_epi8(s, w0), _mm256_cmpeq_epi8(s, w1));
+    x = _mm256_or_si256(x, _mm256_or_si256(_mm256_cmpeq_epi8(s, w2), _mm256_cmpeq_epi8(s, w3)));
+    unsigned r = ~static_cast<unsigned>(_mm256_movemask_epi8(x));
+    if (r != 0) // some of characters are non-whitespace
+      return p + CountTrailingZeros(r);
+  }
+}
+
+//! Skip whitespace with AVX-512 instructions, testing 64 8-byte characters at once.
+JSONCXX_NO_SANITIZE_ADDRESS JSONCXX_TARGET("avx512f,avx512bw")
+inline const char* SkipWhitespace_AVX512(const char* p) {
+  for (const char* aligned = AlignUp(p, 64); p != aligned; ++p)
+    if (!IsWhitespace(*p))
+      return p;
+
+  const __m512i w0 = _mm512_set1_epi8(' ');
+  const __m512i w1 = _mm512_set1_epi8('\n');
+  const __m512i w2 = _mm512_set1_epi8('\r');
+  const __m512i w3 = _mm512_set1_epi8('\t');
+
+  for (;; p += 64) {
+    __m512i s = _mm512_load_si512(reinterpret_cast<const void *>(p));
+    unsigned long long r = ~(_mm512_cmpeq_epi8_mask(s, w0) | _mm512_cmpeq_epi8_mask(s, w1) |
+                             _mm512_cmpeq_epi8_mask(s, w2) | _mm512_cmpeq_epi8_mask(s, w3));
+    if (r != 0) // some of characters are non-whitespace
+      return p + CountTrailingZeros(r);
+  }
+}
+#endif // JSONCXX_SIMD
+
+//! Select the best kernel for skipping whitespace on the host.
+inline const char* (*SelectSkipWhitespace())(const char*) {
+  switch (GetSimdLevel()) {
+#ifdef JSONCXX_SIMD
+  case SimdAVX512:  return &SkipWhitespace_AVX512;
+  case SimdAVX2:    return &SkipWhitespace_AVX2;
+  case SimdSSE42:   return &SkipWhitespace_SSE42;
+  case SimdSSE2:    return &SkipWhitespace_SSE2;
 #endif
-    }
+  default:          return &SkipWhitespace_Scalar;
   }
 }
 
-#elif defined(JSONCXX_SSE2)
+//! Skip whitespace with the best kernel for the host, which is selected on the first call.
+inline const char* SkipWhitespace_SIMD(const char* p) {
+  static const char* (*const kernel)(const char*) = SelectSkipWhitespace();
+  return kernel(p);
+}
 
-//! Skip whitespace with SSE2 instructions, testing 16 8-byte characters at once.
-inline const char *SkipWhitespace_SIMD(const char* p) {
-  static const char whitespaces[4][17] = {
-    "                ",
-    "\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n",
-    "\r\r\r\r\r\r\r\r\r\r\r\r\r\r\r\r",
-    "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t"
-  };
+//! Skip whitespace in a null-terminated string.
+/*! Most runs between tokens are a single space or none, so the first two characters are tested
+ before calling a kernel.
+ */
+inline const char* SkipWhitespace(const char* p) {
+  if (!IsWhitespace(*p))
+    return p;
+  if (!IsWhitespace(*++p))
+    return p;
+  return SkipWhitespace_SIMD(p + 1);
+}
+
+//! Template function specialization for InsituStringStream
+template<> inline void SkipWhitespace(InsituStringStream<UTF8<> >& stream) {
+  stream.src_ = const_cast<char*>(SkipWhitespace(static_cast<const char*>(stream.src_)));
+}
+
+//! Template function specialization for StringStream
+template<> inline void SkipWhitespace(StringStream<UTF8<> >& stream) {
+  stream.src_ = SkipWhitespace(stream.src_);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// ScanString
+
+//! Check whether a character must be escaped in JSON string.
+template <typename CharType>
+inline bool IsControlCharacter(CharType c) {
+  return static_cast<typename std::make_unsigned<CharType>::type>(c) < 0x20;
+}
+
+//! Check whether a character ends the unescaped run of a JSON string.
+template <typename CharType>
+inline bool IsStringSpecial(CharType c) {
+  return c == '\"' || c == '\\' || IsControlCharacter(c);
+}
 
-  __m128i w0 = _mm_loadu_si128((const __m128i *)&whitespaces[0][0]);
-  __m128i w1 = _mm_loadu_si128((const __m128i *)&whitespaces[1][0]);
-  __m128i w2 = _mm_loadu_si128((const __m128i *)&whitespaces[2][0]);
-  __m128i w3 = _mm_loadu_si128((const __m128i *)&whitespaces[3][0]);
+//! Find the first quotation mark, backslash or control character in a null-terminated string.
+/*! \param p A pointer to characters of a string.
+ \note This function has an overload for char, which dispatches to SIMD kernels at runtime.
+ */
+template <typename CharType>
+inline const CharType* ScanString(const CharType* p) {
+  while (!IsStringSpecial(*p))
+    ++p;
+  return p;
+}
+
+#ifdef JSONCXX_SIMD
+//! Scan string with SSE2 instructions, testing 16 8-byte characters at once.
+/*! Loads are aligned, so the scan never reads past the block holding the null terminator
+ and needs no padding after the string.
+ */
+JSONCXX_NO_SANITIZE_ADDRESS JSONCXX_TARGET("sse2")
+inline const char* ScanString_SSE2(const char* p) {
+  for (const char* aligned = AlignUp(p, 16); p != aligned; ++p)
+    if (IsStringSpecial(*p))
+      return p;
+
+  const __m128i quote     = _mm_set1_epi8('\"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i space     = _mm_set1_epi8(0x1F);
+
+  for (;; p += 16) {
+    __m128i s = _mm_load_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i x = _mm_or_si128(_mm_cmpeq_epi8(s, quote), _mm_cmpeq_epi8(s, backslash));
+    x = _mm_or_si128(x, _mm_cmpeq_epi8(_mm_max_epu8(s, space), space)); // s <= 0x1F
+    unsigned r = static_cast<unsigned>(_mm_movemask_epi8(x));
+    if (r != 0) // some of characters are special
+      return p + CountTrailingZeros(r);
+  }
+}
 
+//! Scan string with AVX2 instructions, testing 32 8-byte characters at once.
+JSONCXX_NO_SANITIZE_ADDRESS JSONCXX_TARGET("avx2")
+inline const char* ScanString_AVX2(const char* p) {
+  for (const char* aligned = AlignUp(p, 32); p != aligned; ++p)
+    if (IsStringSpecial(*p))
+      return p;
+
+  const __m256i quote     = _mm256_set1_epi8('\"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  const __m256i space     = _mm256_set1_epi8(0x1F);
+
+  for (;; p += 32) {
+    __m256i s = _mm256_load_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i x = _mm256_or_si256(_mm256_cmpeq_epi8(s, quote), _mm256_cmpeq_epi8(s, backslash));
+    x = _mm256_or_si256(x, _mm256_cmpeq_epi8(_mm256_max_epu8(s, space), space)); // s <= 0x1F
+    unsigned r = static_cast<unsigned>(_mm256_movemask_epi8(x));
+    if (r != 0) // some of characters are special
+      return p + CountTrailingZeros(r);
+  }
+}
+
+//! Scan string with the best kernel for the host, which is selected on the first call.
+inline const char* ScanString(const char* p) {
+  static const char* (*const kernel)(const char*) =
+    GetSimdLevel() >= SimdAVX2 ? &ScanString_AVX2 : GetSimdLevel() >= SimdSSE2 ? &ScanString_SSE2 : &ScanString<char>;
+  return kernel(p);
+}
+#endif // JSONCXX_SIMD
+
+///////////////////////////////////////////////////////////////////////////////
+// SkipValue
+
+//! Skip the characters of a string up to its closing quotation mark.
+/*! \param p A pointer to characters after the opening quotation mark.
+    @return The pointer to the closing quotation mark, or to the null terminator.
+ */
+template <typename CharType>
+inline const CharType* SkipString(const CharType* p) {
   for (;;) {
-    __m128i s = _mm_loadu_si128((const __m128i *)p);
-    __m128i x = _mm_cmpeq_epi8(s, w0);
-    x = _mm_or_si128(x, _mm_cmpeq_epi8(s, w1));
-    x = _mm_or_si128(x, _mm_cmpeq_epi8(s, w2));
-    x = _mm_or_si128(x, _mm_cmpeq_epi8(s, w3));
-    unsigned short r = ~_mm_movemask_epi8(x);
-    if (r == 0) // all 16 characters are whitespace
-      p += 16;
-    else {    // some of characters may be non-whitespace
-#ifdef _MSC_VER   // Find the index of first non-whitespace
-      unsigned long offset;
-      if (_BitScanForward(&offset, r))
-        return p + offset;
-#else
-      if (r != 0)
-        return p + __builtin_ffs(r) - 1;
-#endif
+    p = ScanString(p);
+    switch (*p) {
+    case '\"': case '\0': return p;
+    case '\\':
+      if (*++p == '\0')
+        return p;
+      ++p;  // skip the escaped character
+      break;
+    default: ++p;
     }
   }
 }
 
-#endif // JSONCXX_SSE2
+//! Skip a value without decoding or validating it.
+/*! Brackets are counted, and strings are jumped over with ScanString, so brackets in strings are ignored.
+    \param p A pointer to the first character of the value.
+    @return The pointer to the character after the value.
+ */
+template <typename CharType>
+inline const CharType* SkipValue(const CharType* p) {
+  for (size_t depth = 0; ; ++p) {
+    switch (*p) {
+    case '\"':
+      p = SkipString(p + 1);
+      if (*p == '\0')
+        return p;
+      if (depth == 0)
+        return p + 1;
+      break;
+    case '{': case '[':
+      ++depth;
+      break;
+    case '}': case ']':
+      if (depth == 0)
+        return p;
+      if (--depth == 0)
+        return p + 1;
+      break;
+    case ',':
+      if (depth == 0)
+        return p;
+      break;
+    case '\0':
+      return p;
+    default:
+      if (depth == 0 && IsWhitespace(*p))
+        return p;
+    }
+  }
+}
 
-#ifdef JSONCXX_SIMD
-//! Template function specialization for inplace_stringstream
-template<> inline void SkipWhitespace(insitustringstream& stream) {
-  stream.src_ = const_cast<char*>(SkipWhitespace_SIMD(stream.src_));
+//! Skip a value in stream without decoding or validating it.
+template <typename Stream>
+void SkipValue(Stream& stream) {
+  Stream s = stream;  // Use a local copy for optimization
+  for (size_t depth = 0; ; ) {
+    switch (s.peek()) {
+    case '\"':
+      for (s.take(); s.peek() != '\"' && s.peek() != '\0'; )
+        if (s.take() == '\\' && s.peek() != '\0')
+          s.take();
+      if (s.peek() == '\0') {
+        stream = s;
+        return;
+      }
+      s.take();
+      if (depth == 0) {
+        stream = s;
+        return;
+      }
+      continue;
+    case '{': case '[':
+      ++depth;
+      break;
+    case '}': case ']':
+      if (depth == 0) {
+        stream = s;
+        return;
+      }
+      if (--depth == 0) {
+        s.take();
+        stream = s;
+        return;
+      }
+      break;
+    case ',':
+      if (depth == 0) {
+        stream = s;
+        return;
+      }
+      break;
+    case '\0':
+      stream = s;
+      return;
+    default:
+      if (depth == 0 && IsWhitespace(s.peek())) {
+        stream = s;
+        return;
+      }
+    }
+    s.take();
+  }
 }
 
-//! Template function specialization for stringstream
-template<> inline void SkipWhitespace(stringstream& stream) {
-  stream.src_ = SkipWhitespace_SIMD(stream.src_);
+//! Template function specialization for InsituStringStream
+template<> inline void SkipValue(InsituStringStream<UTF8<> >& stream) {
+  stream.src_ = const_cast<char*>(SkipValue(static_cast<const char*>(stream.src_)));
 }
-#endif // JSONCXX_SIMD
+
+//! Template function specialization for StringStream
+template<> inline void SkipValue(StringStream<UTF8<> >& stream) {
+  stream.src_ = SkipValue(stream.src_);
+}
+
+template <typename Encoding> class Projection;
 
 //! defines parsing error exception
 class parsing_error
@@ -145,6 +449,239 @@ class parsing_error
 
 #define JSONCXX_PARSING_ERROR(msg) throw parsing_error(msg, __FILE__, __LINE__, __FUNCTION__)
 
+//! Combination of parsing flags
+enum ParseFlag {
+  ParseDefaultFlags = 0,  //!< Default parse flags.
+  ParseInsituFlag   = 1,  //!< In-situ (destructive) parsing. Requires a writable stream (see StreamTraits) such as InsituStringStream.
+  ParseIterativeFlag = 2, //!< Iterative parsing with a stack on the heap instead of recursion, for limits of nesting deeper than the call stack allows.
+  ParseValidateEncodingFlag = 4, //!< Check that strings are well-formed in the encoding.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// ParseResult
+
+//! Error codes of parsing.
+enum ParseErrorCode {
+  ParseErrorNone = 0,                       //!< No error.
+  ParseErrorValueInvalid,                   //!< Invalid value.
+  ParseErrorValueTooDeep,                   //!< Nesting deeper than the limit of the reader.
+  ParseErrorDocumentRootNotSingular,        //!< The document root is followed by other characters.
+  ParseErrorObjectMissName,                 //!< Name of an object member is not a string.
+  ParseErrorObjectMissColon,                //!< No colon after the name of an object member.
+  ParseErrorObjectMissCommaOrCurlyBracket,  //!< No comma or '}' after an object member.
+  ParseErrorArrayMissCommaOrSquareBracket,  //!< No comma or ']' after an array element.
+  ParseErrorStringMissQuotationMark,        //!< No closing quotation mark before the end of input.
+  ParseErrorStringInvalidControlCharacter,  //!< Unescaped control character in string.
+  ParseErrorStringEscapeInvalid,            //!< Invalid escape character in string.
+  ParseErrorStringUnicodeEscapeInvalidHex,  //!< Incorrect hex digit after \u escape.
+  ParseErrorStringUnicodeSurrogateInvalid,  //!< Invalid surrogate pair in string.
+  ParseErrorStringInvalidEncoding,          //!< String is not well-formed in the encoding.
+  ParseErrorNumberTooBig,                   //!< Number too big to be stored in double.
+  ParseErrorNumberMissFraction,             //!< No digit after the decimal point.
+  ParseErrorNumberMissExponent,             //!< No digit in the exponent.
+};
+
+//! Get the message of an error code.
+inline const char* GetParseErrorMessage(ParseErrorCode code) {
+  switch (code) {
+  case ParseErrorNone:                          return "No error";
+  case ParseErrorValueInvalid:                  return "Invalid value";
+  case ParseErrorValueTooDeep:                  return "Values are nested too deep";
+  case ParseErrorDocumentRootNotSingular:       return "The document root must not be followed by other values";
+  case ParseErrorObjectMissName:                return "Name of an object member must be a string";
+  case ParseErrorObjectMissColon:               return "There must be a colon after the name of object member";
+  case ParseErrorObjectMissCommaOrCurlyBracket: return "Must be a comma or '}' after an object member";
+  case ParseErrorArrayMissCommaOrSquareBracket: return "Must be a comma or ']' after an array member";
+  case ParseErrorStringMissQuotationMark:       return "Lacks ending quation before the the end of string";
+  case ParseErrorStringInvalidControlCharacter: return "Invalid control character in string";
+  case ParseErrorStringEscapeInvalid:           return "Invalid escape character in string";
+  case ParseErrorStringUnicodeEscapeInvalidHex: return "Incorrect hex digit after \\u escape";
+  case ParseErrorStringUnicodeSurrogateInvalid: return "The surrogate pair in string is invalid";
+  case ParseErrorStringInvalidEncoding:         return "Invalid encoding in string";
+  case ParseErrorNumberTooBig:                  return "Number too big to be stored in double";
+  case ParseErrorNumberMissFraction:            return "Missing fraction part in number";
+  case ParseErrorNumberMissExponent:            return "Missing exponent in number";
+  default:                                      return "Unknown error";
+  }
+}
+
+//! Result of parsing, which is an error code and the offset where the error was found.
+/*! It is cheap to make and return, and the text of the error is only made by describe().
+ */
+struct ParseResult {
+  ParseResult() : code(ParseErrorNone), offset(0) {}
+  ParseResult(ParseErrorCode code, size_t offset) : code(code), offset(offset) {}
+
+  //! Check whether parsing succeeded.
+  inline explicit operator bool() const { return code == ParseErrorNone; }
+
+  inline const char* message() const    { return GetParseErrorMessage(code); }
+
+  //! Describe the error with its line and column, which are counted in the parsed document.
+  /*! \param json Characters of the document from the start of the stream.
+   */
+  template <typename CharType>
+  std::string describe(const CharType* json) const {
+    size_t line = 1, column = 1;
+    for (size_t i = 0; i < offset; ++i) {
+      if (json[i] == '\n') {
+        ++line;
+        column = 1;
+      } else
+        ++column;
+    }
+
+    std::ostringstream oss;
+    oss << "line " << line << ", column " << column << ": " << message();
+    return oss.str();
+  }
+
+  ParseErrorCode  code;
+  size_t          offset; //!< Offset of the error from the start of the stream, in characters.
+};
+
+//! Record a parsing error in Reader and return value from the current function.
+#define JSONCXX_PARSE_ERROR_RETURN(code, offset, value) \
+  do { result_ = ParseResult(code, offset); return value; } while (0)
+
+//! Record a parsing error in Reader and return from the current function.
+#define JSONCXX_PARSE_ERROR(code, offset) JSONCXX_PARSE_ERROR_RETURN(code, offset, )
+
+//! Return from the current function if Reader has recorded a parsing error.
+#define JSONCXX_PARSE_CHECK() \
+  do { if (result_.code != ParseErrorNone) return; } while (0)
+
+///////////////////////////////////////////////////////////////////////////////
+// Handler
+
+/*! @class jsoncxx::Handler
+    @brief Concept for receiving events from Reader.
+
+    Reader drives the JSON grammar and reports every value it meets to a handler,
+    so a document can be consumed without building a Value tree.
+    Strings passed to a handler are only valid during the call, and not necessarily null-terminated,
+    unless @c copy is false.
+
+    @code
+    concept Handler {
+        void null();
+        void boolean(bool b);
+        void number(natural n);
+        void number(real r);
+
+        //! @param copy true if the characters live in a temporary buffer and must be copied to be kept.
+        void string(const char_type* str, size_type length, bool copy);
+
+        void startObject();
+        void key(const char_type* str, size_type length, bool copy);
+        void endObject(size_type memberCount);
+
+        void startArray();
+        void endArray(size_type elementCount);
+    };
+    @endcode
+ */
+
+//! Default implementation of Handler which ignores every event.
+template <typename Encoding = UTF8<> >
+struct BaseHandler {
+  typedef typename Encoding::char_type char_type;
+
+  void null() {}
+  void boolean(bool) {}
+  void number(natural) {}
+  void number(real) {}
+  void string(const char_type*, size_type, bool) {}
+  void startObject() {}
+  void key(const char_type*, size_type, bool) {}
+  void endObject(size_type) {}
+  void startArray() {}
+  void endArray(size_type) {}
+};
+
+//! Handler which builds a Value tree from the events of Reader.
+/*! The tree is allocated from the heap, or from a MemoryResource given to the constructor.
+
+    @code
+    std::pmr::synchronized_pool_resource pool;
+    jsoncxx::ValueHandler<> handler(&pool);
+    jsoncxx::reader().parse(s, handler);
+    jsoncxx::value root = handler.release();  // must not outlive pool
+    @endcode
+ */
+template <typename Encoding = UTF8<> >
+class ValueHandler {
+ public:
+  typedef typename Encoding::char_type  char_type;
+  typedef Value<Encoding>               value_type;
+
+  //! Constructor.
+  /*! \param resource Resource to allocate copied strings and containers from, or null for the heap.
+   */
+  explicit ValueHandler(MemoryResource* resource = 0) : resource_(resource) {}
+
+  void null()                 { stack_.emplace_back(); }
+  void boolean(bool b)        { stack_.emplace_back(b); }
+  void number(natural n)      { stack_.emplace_back(n); }
+  void number(real r)         { stack_.emplace_back(r); }
+
+  void string(const char_type* str, size_type length, bool copy) {
+    if (copy)
+      stack_.emplace_back(str, length, resource_);
+    else
+      stack_.emplace_back(StringRef<char_type>(str, length));
+  }
+
+  void startObject()          {}
+  void key(const char_type* str, size_type length, bool copy) { string(str, length, copy); }
+
+  void endObject(size_type memberCount) {
+    value_type object(ObjectType, resource_);
+    auto first = stack_.end() - 2 * memberCount;
+    for (auto itr = first; itr != stack_.end(); itr += 2)
+      object.insert(std::move(*itr), std::move(*(itr + 1)));
+    stack_.erase(first, stack_.end());
+    stack_.push_back(std::move(object));
+  }
+
+  void startArray()           {}
+
+  void endArray(size_type elementCount) {
+    value_type array(ArrayType, resource_);
+    array.reserve(elementCount);
+    auto first = stack_.end() - elementCount;
+    for (auto itr = first; itr != stack_.end(); ++itr)
+      array.append(std::move(*itr));
+    stack_.erase(first, stack_.end());
+    stack_.push_back(std::move(array));
+  }
+
+  //! Take the root value out of the handler.
+  value_type release() {
+    JSONCXX_ASSERT(stack_.size() == 1);
+    value_type root = std::move(stack_.back());
+    stack_.clear();
+    return root;
+  }
+
+ private:
+  std::vector<value_type> stack_; //!< Values whose parent is not complete yet.
+  MemoryResource*         resource_;
+};
+
+//! Handler adapter which reports strings parsed by Reader as names of object members.
+/*! Used by readers which find the tokens of a document themselves and parse them one at a time.
+ */
+template <typename Handler, typename Encoding = UTF8<> >
+struct KeyHandler : public BaseHandler<Encoding> {
+  typedef typename Encoding::char_type char_type;
+
+  explicit KeyHandler(Handler& handler) : handler_(handler) {}
+  void string(const char_type* str, size_type length, bool copy) { handler_.key(str, length, copy); }
+
+  Handler& handler_;
+};
+
 //! Generic reader class
 template <typename Stream, typename Encoding = UTF8<> >
 class Reader {
@@ -156,205 +693,877 @@ class Reader {
   typedef Value<Encoding>                 value_type;
   typedef Value<Encoding>                 key_type;
 
-  bool parse(const string& filename, value_type& root) {
-    ifstream fin(filename);
-    if (fin.is_open()) {
-
-      string json;
-      std::getline(fin, json, (char_type)EOF);
-      fin.close(); // preliminary implementation read entire file at once.
+  //! Constructor.
+  /*! \param maxDepth Maximum nesting of arrays and objects, beyond which parsing fails with ParseErrorValueTooDeep.
+      Recursive parsing takes stack in proportion to the nesting, so raise it far beyond the default only with
+      ParseIterativeFlag. Values of any depth are destroyed without recursion, but copying and writing them recurse.
+   */
+  explicit Reader(size_type maxDepth = JSONCXX_MAX_DEPTH) : depth_(0), maxDepth_(maxDepth) {}
 
-      stringstream s(json.c_str());
-      root = parse(s);
+  //! Parse a file, which is memory-mapped and parsed without copying it.
+  bool parse(const std::string& filename, value_type& root) {
+    MemoryMappedFile<Encoding> file(filename.c_str());
+    if (file.isOpen()) {
+      stringstream s(file.data());
+      root = Reader<stringstream, Encoding>().parse(s);
 
       return true;
     }
     return false;
   }
 
+  //! Parse a value from stream.
+  /*! \tparam parseFlags Combination of ParseFlag.
+      With ParseInsituFlag, strings of the returned value refer to the buffer of the stream.
+   */
+  template <unsigned parseFlags = ParseDefaultFlags>
   value_type parse(Stream& s) {
-    SkipWhitespace(s);
+    ValueHandler<Encoding> handler;
+    parse<parseFlags>(s, handler);
+    return handler.release();
+  }
 
-    switch (s.peek()) {
-    case 'n': return parseNull  (s);
-    case 't': return parseTrue  (s);
-    case 'f': return parseFalse (s);
-    case '"': return parseString(s);
-    case '{': return parseObject(s);
-    case '[': return parseArray (s);
+  //! Parse a value from stream and report it to handler without building a Value tree.
+  /*! Throws parsing_error on error. Exceptions thrown by the handler are passed to the caller.
+   */
+  template <unsigned parseFlags = ParseDefaultFlags, typename Handler>
+  void parse(Stream& s, Handler& handler) {
+    parseRoot<parseFlags>(s, handler);
+    if (!result_)
+      JSONCXX_PARSING_ERROR(result_.message());
+  }
+
+  //! Parse a value from stream without throwing on parsing errors.
+  /*! Errors are returned as in tryParse(Stream&, Handler&). On error, root is unchanged.
+      Building the value allocates, so std::bad_alloc is thrown if memory runs out.
+      \param resource Resource to allocate copied strings and containers from, or null for the heap.
+   */
+  template <unsigned parseFlags = ParseDefaultFlags>
+  ParseResult tryParse(Stream& s, value_type& root, MemoryResource* resource = 0) {
+    ValueHandler<Encoding> handler(resource);
+    parseRoot<parseFlags>(s, handler);
+    if (result_)
+      root = handler.release();
+    return result_;
+  }
+
+  //! Parse a value from stream and report it to handler without throwing.
+  /*! Errors are returned as an error code and the offset given by Stream::tell(), without
+      formatting a message. The handler must not throw, since an exception leaving it terminates
+      the program; use parse(Stream&, Handler&) for handlers which throw.
+   */
+  template <unsigned parseFlags = ParseDefaultFlags, typename Handler>
+  ParseResult tryParse(Stream& s, Handler& handler) noexcept {
+    parseRoot<parseFlags>(s, handler);
+    return result_;
+  }
+
+  //! Check that stream holds a single valid value, without building it.
+  /*! The grammar is checked by iterative parsing up to maxDepth(), strings must be well-formed in Encoding,
+      and only white spaces may follow the value up to the end of the stream.
+      Nothing is allocated, except that the buffers of the reader grow on its first uses.
+   */
+  template <unsigned parseFlags = ParseDefaultFlags>
+  ParseResult validate(Stream& s) noexcept {
+    BaseHandler<Encoding> handler;
+    ParseResult result = tryParse<parseFlags | ParseIterativeFlag | ParseValidateEncodingFlag>(s, handler);
+    if (result) {
+      SkipWhitespace(s);
+      if (s.peek() != '\0')
+        result = ParseResult(ParseErrorDocumentRootNotSingular, s.tell());
     }
+    return result;
+  }
 
-    return parseNumber(s);
+  //! Parse the values at the paths of a projection from stream.
+  /*! Only the values on the paths are materialized. A path to a missing value, or through a value which
+      is not a container, selects nothing, in arrays as in objects. Other members are left out, and other
+      elements of arrays are left out or, if a materialized element follows them, replaced by null to keep
+      its index; no nulls are added after the last element of an array.
+
+      Values which are not selected are skipped by SkipValue() without being decoded or validated: the
+      structure of the containers on the paths is checked, so an empty member or element such as
+      {"a":} or [1,] is an error, but e.g. [1 2] inside a skipped value is not.
+   */
+  template <unsigned parseFlags = ParseDefaultFlags>
+  value_type project(Stream& s, const Projection<Encoding>& projection) {
+    ValueHandler<Encoding> handler;
+    project<parseFlags>(s, projection, handler);
+    return handler.release();
   }
 
+  //! Parse the values at the paths of a projection from stream and report them to handler.
+  template <unsigned parseFlags = ParseDefaultFlags, typename Handler>
+  void project(Stream& s, const Projection<Encoding>& projection, Handler& handler) {
+    result_ = ParseResult();
+    depth_ = 0;
+    parseProjected<parseFlags>(s, handler, projection, 0);
+    if (!result_)
+      JSONCXX_PARSING_ERROR(result_.message());
+  }
+
+  //! Get the maximum nesting of arrays and objects.
+  inline size_type maxDepth() const { return maxDepth_; }
+
  private:
   //! @brief  Internal handlers for each of the value types.
   //! @{
 
-  //! @brief  Parse object from stream
-  //!     object:{name:value, ...}
-  value_type parseObject(Stream& s) {
-    assert(s.peek() == '{');
+  //! Parse the root value from stream, recording an error in result_.
+  /*! Exceptions of the handler are passed through, so each entry point chooses whether they may be thrown.
+   */
+  template <unsigned parseFlags, typename Handler>
+  void parseRoot(Stream& s, Handler& handler) {
+    result_ = ParseResult();
+    depth_ = 0;
+    if (parseFlags & ParseIterativeFlag)
+      parseIterative<parseFlags>(s, handler);
+    else
+      parseValue<parseFlags>(s, handler);
+  }
+
+  //! Parse any value from stream.
+  template <unsigned parseFlags, typename Handler>
+  void parseValue(Stream& s, Handler& handler) {
+    SkipWhitespace(s);
+
+    switch (s.peek()) {
+    case 'n': parseNull  (s, handler); break;
+    case 't': parseTrue  (s, handler); break;
+    case 'f': parseFalse (s, handler); break;
+    case '"': parseString<parseFlags>(s, handler, false); break;
+    case '{': parseObject<parseFlags>(s, handler); break;
+    case '[': parseArray <parseFlags>(s, handler); break;
+    default:  parseNumber(s, handler);
+    }
+  }
+
+  //! Parse any value from stream without recursion.
+  /*! Open arrays and objects are kept in a stack which is reused by the next parse,
+      so nesting is only limited by maxDepth().
+   */
+  template <unsigned parseFlags, typename Handler>
+  void parseIterative(Stream& s, Handler& handler) {
+    stack_.clear();
+
+    for (;;) {
+      // at a value
+      SkipWhitespace(s);
+
+      switch (s.peek()) {
+      case '{':
+        if (stack_.size() >= maxDepth_)
+          JSONCXX_PARSE_ERROR(ParseErrorValueTooDeep, s.tell());
+        s.take();
+        handler.startObject();
+        SkipWhitespace(s);
+        if (s.peek() == '}') {
+          s.take();
+          handler.endObject(0);
+          break;
+        }
+        stack_.push_back(Frame(true));
+        parseName<parseFlags>(s, handler);
+        JSONCXX_PARSE_CHECK();
+        continue;
+      case '[':
+        if (stack_.size() >= maxDepth_)
+          JSONCXX_PARSE_ERROR(ParseErrorValueTooDeep, s.tell());
+        s.take();
+        handler.startArray();
+        SkipWhitespace(s);
+        if (s.peek() == ']') {
+          s.take();
+          handler.endArray(0);
+          break;
+        }
+        stack_.push_back(Frame(false));
+        continue;
+      case 'n': parseNull  (s, handler); break;
+      case 't': parseTrue  (s, handler); break;
+      case 'f': parseFalse (s, handler); break;
+      case '"': parseString<parseFlags>(s, handler, false); break;
+      default:  parseNumber(s, handler);
+      }
+      JSONCXX_PARSE_CHECK();
+
+      // after a value, close the containers it completes
+      for (;;) {
+        if (stack_.empty())
+          return;
+
+        SkipWhitespace(s);
+
+        Frame& frame = stack_.back();
+        ++frame.count_;
+        char_type c = s.peek();
+        if (c == ',') {
+          s.take();
+          if (frame.object_) {
+            SkipWhitespace(s);
+            parseName<parseFlags>(s, handler);
+            JSONCXX_PARSE_CHECK();
+          }
+          break;
+        }
+
+        if (frame.object_) {
+          if (c != '}')
+            JSONCXX_PARSE_ERROR(ParseErrorObjectMissCommaOrCurlyBracket, s.tell());
+          s.take();
+          handler.endObject(frame.count_);
+        } else {
+          if (c != ']')
+            JSONCXX_PARSE_ERROR(ParseErrorArrayMissCommaOrSquareBracket, s.tell());
+          s.take();
+          handler.endArray(frame.count_);
+        }
+        stack_.pop_back();
+      }
+    }
+  }
+
+  //! Handler which keeps the name of a member to report it later.
+  struct KeyCapture : public BaseHandler<Encoding> {
+    void key(const char_type* str, size_type length, bool copy) {
+      str_ = str;
+      length_ = length;
+      copy_ = copy;
+    }
+
+    const char_type*  str_;
+    size_type         length_;
+    bool              copy_;
+  };
+
+  //! Parse the value of a node of projection, skipping the children which are not selected.
+  template <unsigned parseFlags, typename Handler>
+  void parseProjected(Stream& s, Handler& handler, const Projection<Encoding>& projection, size_t node) {
+    SkipWhitespace(s);
+
+    if (projection.whole(node)) {
+      parseValue<parseFlags>(s, handler);
+      return;
+    }
+
+    switch (s.peek()) {
+    case '{': parseProjectedObject<parseFlags>(s, handler, projection, node); break;
+    case '[': parseProjectedArray <parseFlags>(s, handler, projection, node); break;
+    default:
+      // paths go through a root which is not a container, so the document is null
+      skipProjected(s);
+      JSONCXX_PARSE_CHECK();
+      handler.null();
+    }
+  }
+
+  template <unsigned parseFlags, typename Handler>
+  void parseProjectedObject(Stream& s, Handler& handler, const Projection<Encoding>& projection, size_t node) {
+    if (depth_ >= maxDepth_)
+      JSONCXX_PARSE_ERROR(ParseErrorValueTooDeep, s.tell());
 
-    value_type ret(ObjectType);
     s.take(); // skip '{'
+    handler.startObject();
     SkipWhitespace(s);
 
-    if (s.peek() == '}') { // empty object
+    size_type memberCount = 0;
+    if (s.peek() == '}') {
       s.take();
-      return ret;
+      handler.endObject(memberCount);
+      return;
     }
 
-    while (true) {
+    ++depth_;
+
+    for (;;) {
       if (s.peek() != '"')
-        JSONCXX_PARSING_ERROR("Name of an object member must be a string"); // stream.tell();
+        JSONCXX_PARSE_ERROR(ParseErrorObjectMissName, s.tell());
+
+      KeyCapture name;
+      parseString<parseFlags>(s, name, true);
+      JSONCXX_PARSE_CHECK();
+
+      SkipWhitespace(s);
 
-      key_type key = parseString(s);
+      if (s.peek() != ':')
+        JSONCXX_PARSE_ERROR(ParseErrorObjectMissColon, s.tell());
+      s.take();
 
       SkipWhitespace(s);
 
-      if (s.take() != ':')
-        JSONCXX_PARSING_ERROR("There must be a colon after the name of object member"); // stream.tell();
+      size_t child = projection.member(node, name.str_, name.length_);
+      if (child != 0 && (projection.whole(child) || s.peek() == '{' || s.peek() == '[')) {
+        handler.key(name.str_, name.length_, name.copy_);
+        parseProjected<parseFlags>(s, handler, projection, child);
+        JSONCXX_PARSE_CHECK();
+        ++memberCount;
+      } else {
+        skipProjected(s);
+        JSONCXX_PARSE_CHECK();
+      }
 
       SkipWhitespace(s);
 
-      ret.insert(std::move(key), parse(s));
+      switch (s.peek()) {
+      case ',': s.take(); SkipWhitespace(s); break;
+      case '}': s.take(); --depth_; handler.endObject(memberCount); return;
+      default: JSONCXX_PARSE_ERROR(ParseErrorObjectMissCommaOrCurlyBracket, s.tell());
+      }
+    }
+  }
+
+  template <unsigned parseFlags, typename Handler>
+  void parseProjectedArray(Stream& s, Handler& handler, const Projection<Encoding>& projection, size_t node) {
+    if (depth_ >= maxDepth_)
+      JSONCXX_PARSE_ERROR(ParseErrorValueTooDeep, s.tell());
+
+    s.take(); // skip '['
+    handler.startArray();
+    SkipWhitespace(s);
+
+    size_type elementCount = 0;
+    if (s.peek() == ']') {
+      s.take();
+      handler.endArray(elementCount);
+      return;
+    }
+
+    ++depth_;
+
+    typename Projection<Encoding>::element_iterator next = projection.elementsBegin(node), end = projection.elementsEnd(node);
+    size_type omitted = 0;  // elements left out since the last materialized one
+    for (size_type index = 0;; ++index) {
+      bool selected = next != end && next->first == index;
+      if (selected && (projection.whole(next->second) || s.peek() == '{' || s.peek() == '[')) {
+        for (; omitted > 0; --omitted, ++elementCount) // keep the index of this element
+          handler.null();
+        parseProjected<parseFlags>(s, handler, projection, next->second);
+        JSONCXX_PARSE_CHECK();
+        ++elementCount;
+      } else {
+        skipProjected(s);
+        JSONCXX_PARSE_CHECK();
+        ++omitted;
+      }
+      if (selected)
+        ++next;
 
       SkipWhitespace(s);
 
-      switch (s.take()) {
-      case ',': SkipWhitespace(s); break;
-      case '}': return ret;
-      default: JSONCXX_PARSING_ERROR("Must be a comma or '}' after an object member"); // stream.tell();
+      switch (s.peek()) {
+      case ',': s.take(); SkipWhitespace(s); break;
+      case ']': s.take(); --depth_; handler.endArray(elementCount); return;
+      default: JSONCXX_PARSE_ERROR(ParseErrorArrayMissCommaOrSquareBracket, s.tell());
       }
     }
+  }
+
+  //! Skip a member or an element which is not selected. It must not be empty.
+  void skipProjected(Stream& s) {
+    size_t offset = s.tell();
+    SkipValue(s);
+    if (s.tell() == offset)
+      JSONCXX_PARSE_ERROR(ParseErrorValueInvalid, offset);
+  }
+
+  //! Parse the name of an object member and the following colon.
+  template <unsigned parseFlags, typename Handler>
+  void parseName(Stream& s, Handler& handler) {
+    if (s.peek() != '"')
+      JSONCXX_PARSE_ERROR(ParseErrorObjectMissName, s.tell());
+
+    parseString<parseFlags>(s, handler, true);
+    JSONCXX_PARSE_CHECK();
+
+    SkipWhitespace(s);
+
+    if (s.peek() != ':')
+      JSONCXX_PARSE_ERROR(ParseErrorObjectMissColon, s.tell());
+    s.take();
+  }
+
+  //! @brief  Parse object from stream
+  //!     object:{name:value, ...}
+  template <unsigned parseFlags, typename Handler>
+  void parseObject(Stream& s, Handler& handler) {
+    assert(s.peek() == '{');
+    if (depth_ >= maxDepth_)
+      JSONCXX_PARSE_ERROR(ParseErrorValueTooDeep, s.tell());
+
+    s.take(); // skip '{'
+    handler.startObject();
+    SkipWhitespace(s);
+
+    if (s.peek() == '}') { // empty object
+      s.take();
+      handler.endObject(0);
+      return;
+    }
+
+    ++depth_; // restored on success; a failed parse resets it
+
+    for (size_type memberCount = 0;;) {
+      parseName<parseFlags>(s, handler);
+      JSONCXX_PARSE_CHECK();
 
-    return ret;
+      SkipWhitespace(s);
+
+      parseValue<parseFlags>(s, handler);
+      JSONCXX_PARSE_CHECK();
+      ++memberCount;
+
+      SkipWhitespace(s);
+
+      switch (s.peek()) {
+      case ',': s.take(); SkipWhitespace(s); break;
+      case '}': s.take(); --depth_; handler.endObject(memberCount); return;
+      default: JSONCXX_PARSE_ERROR(ParseErrorObjectMissCommaOrCurlyBracket, s.tell());
+      }
+    }
   }
 
   //! @brief  Parse array from stream
   //!     array: [ value, ... ]
-  value_type parseArray(Stream& s) {
+  template <unsigned parseFlags, typename Handler>
+  void parseArray(Stream& s, Handler& handler) {
     assert(s.peek() == '[');
+    if (depth_ >= maxDepth_)
+      JSONCXX_PARSE_ERROR(ParseErrorValueTooDeep, s.tell());
+
     s.take(); // skip '['
+    handler.startArray();
     SkipWhitespace(s);
 
-    value_type ret(ArrayType);
-
     if (s.peek() == ']') {
       s.take();
-      return ret;
+      handler.endArray(0);
+      return;
     }
 
-    while (true) {
-      ret.append(parse(s));
+    ++depth_; // restored on success; a failed parse resets it
+
+    for (size_type elementCount = 0;;) {
+      parseValue<parseFlags>(s, handler);
+      JSONCXX_PARSE_CHECK();
+      ++elementCount;
 
       SkipWhitespace(s);
 
-      switch (s.take()) {
-      case ',': SkipWhitespace(s); break;
-      case ']': return ret;
-      default: JSONCXX_PARSING_ERROR("Must be a comma or ']' after an array member"); // stream.tell();
+      switch (s.peek()) {
+      case ',': s.take(); SkipWhitespace(s); break;
+      case ']': s.take(); --depth_; handler.endArray(elementCount); return;
+      default: JSONCXX_PARSE_ERROR(ParseErrorArrayMissCommaOrSquareBracket, s.tell());
       }
     }
-
-    return ret;
   }
 
   //! Parse null value from stream
-  value_type parseNull(Stream& s) {
+  template <typename Handler>
+  void parseNull(Stream& s, Handler& handler) {
     JSONCXX_ASSERT(s.peek() == 'n');
+    size_t offset = s.tell();
     s.take();
 
     if (s.take() == 'u' &&
         s.take() == 'l' &&
         s.take() == 'l')
-      return value_type(); // null
+      handler.null();
     else
-      JSONCXX_PARSING_ERROR("Invalid value"); // stream.tell() - 1;
+      JSONCXX_PARSE_ERROR(ParseErrorValueInvalid, offset);
   }
 
   //! Parse true value from stream
-  value_type parseTrue(Stream& s) {
+  template <typename Handler>
+  void parseTrue(Stream& s, Handler& handler) {
     JSONCXX_ASSERT(s.peek() == 't');
+    size_t offset = s.tell();
     s.take();
 
     if (s.take() == 'r' &&
         s.take() == 'u' &&
         s.take() == 'e')
-      return value_type(TrueType); // true
+      handler.boolean(true);
     else
-      JSONCXX_PARSING_ERROR("Invalid value"); // stream.tell() - 1;
+      JSONCXX_PARSE_ERROR(ParseErrorValueInvalid, offset);
   }
 
   //! Parse false value from stream
-  value_type parseFalse(Stream& s) {
+  template <typename Handler>
+  void parseFalse(Stream& s, Handler& handler) {
     JSONCXX_ASSERT(s.peek() == 'f');
+    size_t offset = s.tell();
     s.take();
 
     if (s.take() == 'a' &&
         s.take() == 'l' &&
         s.take() == 's' &&
         s.take() == 'e')
-      return value_type(FalseType); // false
+      handler.boolean(false);
     else
-      JSONCXX_PARSING_ERROR("Invalid value"); // stream.tell() - 1;
+      JSONCXX_PARSE_ERROR(ParseErrorValueInvalid, offset);
   }
 
   //! Parse number value from stream
-  value_type parseNumber(Stream& s) {
+  /*! Integers of up to 19 digits which fit in natural are reported as natural, others as real;
+      -0 is reported as real to keep its sign. Decimal significands of up to 19 digits with small
+      exponents are converted exactly with one floating-point operation; others are correctly rounded
+      by strtod in the "C" locale.
+   */
+  template <typename Handler>
+  void parseNumber(Stream& s, Handler& handler) {
     Stream s_ = s; // Local copy for optimization
 
-    // parse number
-    while ((s_.peek() >= '0' && s_.peek() <= '9') ||
-           s_.peek() == '.' ||
-           s_.peek() == 'e' || s_.peek() == 'E' ||
-           s_.peek() == '-' || s_.peek() == '+')
+    // Significant digits, with the decimal exponent of the last one.
+    // Digits beyond JSONCXX_MAX_DIGITS are dropped and only remembered by inexact.
+    char digits[JSONCXX_MAX_DIGITS + 32];
+    int length = 0;
+    int exponent = 0;
+    bool inexact = false;
+    unsigned long long significand = 0; // first 19 significant digits
+
+    bool minus = false;
+    if (s_.peek() == '-') {
+      minus = true;
       s_.take();
+    }
 
-    value_type ret;
+    // integer part
+    if (s_.peek() == '0')
+      s_.take();
+    else if (s_.peek() >= '1' && s_.peek() <= '9') {
+      while (s_.peek() >= '0' && s_.peek() <= '9') {
+        char d = (char)s_.take();
+        if (length < JSONCXX_MAX_DIGITS) {
+          if (length < 19)
+            significand = significand * 10 + (d - '0');
+          digits[length++] = d;
+        } else {
+          ++exponent;
+          inexact |= d != '0';
+        }
+      }
+    } else
+      JSONCXX_PARSE_ERROR(ParseErrorValueInvalid, s.tell());
 
-    std::string number(s.src_, s_.src_);
+    bool integer = true;
 
-    if (number.find('.') != std::string::npos ||
-        number.find('e') != std::string::npos ||
-        number.find('E') != std::string::npos)
-      ret = std::move(value_type((real)std::stod(number)));
-    else
-      ret = std::move(value_type((natural)std::stoll(number)));
+    // fraction part
+    if (s_.peek() == '.') {
+      s_.take();
+      integer = false;
+
+      if (!(s_.peek() >= '0' && s_.peek() <= '9'))
+        JSONCXX_PARSE_ERROR(ParseErrorNumberMissFraction, s_.tell());
+
+      while (s_.peek() >= '0' && s_.peek() <= '9') {
+        char d = (char)s_.take();
+        if (length == 0 && d == '0')
+          --exponent; // leading zero
+        else if (length < JSONCXX_MAX_DIGITS) {
+          if (length < 19)
+            significand = significand * 10 + (d - '0');
+          digits[length++] = d;
+          --exponent;
+        } else
+          inexact |= d != '0';
+      }
+    }
+
+    // exponent part
+    if (s_.peek() == 'e' || s_.peek() == 'E') {
+      s_.take();
+      integer = false;
+
+      bool negative = false;
+      if (s_.peek() == '+')
+        s_.take();
+      else if (s_.peek() == '-') {
+        negative = true;
+        s_.take();
+      }
+
+      if (!(s_.peek() >= '0' && s_.peek() <= '9'))
+        JSONCXX_PARSE_ERROR(ParseErrorNumberMissExponent, s_.tell());
+
+      int e = 0;
+      while (s_.peek() >= '0' && s_.peek() <= '9') {
+        e = e * 10 + (s_.take() - '0');
+        if (e > 100000)
+          e = 100000; // far beyond the range of real, avoid overflow
+      }
+      exponent += negative ? -e : e;
+    }
 
     s = s_;
 
-    return ret;
+    if (integer && length <= 19 && exponent == 0 && !(minus && length == 0)) {
+      const unsigned long long limit = 9223372036854775807ULL;
+      if (significand <= limit) {
+        handler.number(minus ? -(natural)significand : (natural)significand);
+        return;
+      }
+      if (minus && significand == limit + 1) {
+        handler.number((natural)(-(natural)limit - 1));
+        return;
+      }
+    }
+
+    real r;
+    if (length == 0)
+      r = 0.0;
+    else if (length <= 19 && !inexact && significand <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+      // Both significand and power of 10 are exact, so a single operation rounds correctly.
+      static const real pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+      };
+      r = (real)significand;
+      r = exponent < 0 ? r / pow10[-exponent] : r * pow10[exponent];
+    } else {
+      // A trailing nonzero digit stands for the dropped ones, which is enough to round correctly.
+      if (inexact) {
+        digits[length++] = '1';
+        --exponent;
+      }
+      std::snprintf(digits + length, sizeof(digits) - length, "e%d", exponent);
+      r = convertReal(digits);
+      if (r == HUGE_VAL)
+        JSONCXX_PARSE_ERROR(ParseErrorNumberTooBig, s.tell());
+    }
+
+    handler.number(minus ? -r : r);
+  }
+
+  //! Convert a decimal number to real independently of the current locale.
+  static real convertReal(const char* str) {
+#if defined(_MSC_VER)
+    static _locale_t locale = _create_locale(LC_NUMERIC, "C");
+    return _strtod_l(str, 0, locale);
+#elif defined(__GLIBC__) || defined(__APPLE__) || defined(__FreeBSD__)
+    static locale_t locale = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
+    return strtod_l(str, 0, locale);
+#else
+    return std::strtod(str, 0);
+#endif
   }
 
   //! @brief  Parse string value from stream
-  //! @note This implementation do not support "u" literal, 4 hexadecimal digits
-  value_type parseString(Stream& s) {
+  //! @param  isKey true if the string is the name of an object member.
+  template <unsigned parseFlags, typename Handler>
+  void parseString(Stream& s, Handler& handler, bool isKey) {
     JSONCXX_ASSERT(s.peek() == '\"');
+    size_t offset = s.tell();
     s.take(); // skip '\"'
 
+    parseString<parseFlags>(s, handler, isKey, offset, std::integral_constant<bool, StreamTraits<Stream>::contiguous>());
+  }
+
+  //! Report a decoded string to handler.
+  /*! \param offset Offset of the opening quotation mark, where an invalid encoding is reported.
+   */
+  template <unsigned parseFlags, typename Handler>
+  void reportString(Handler& handler, bool isKey, const char_type* str, size_type length, bool copy, size_t offset) {
+    if ((parseFlags & ParseValidateEncodingFlag) && !Encoding::Validate(str, length))
+      JSONCXX_PARSE_ERROR(ParseErrorStringInvalidEncoding, offset);
+
+    if (isKey)
+      handler.key(str, length, copy);
+    else
+      handler.string(str, length, copy);
+  }
+
+  //! Parse string whose characters can be referred in the buffer of stream.
+  /*! A string without escape sequences is handed over in place. Otherwise it is decoded to
+      the internal buffer, or back into the source buffer with in-situ parsing.
+   */
+  template <unsigned parseFlags, typename Handler>
+  void parseString(Stream& s, Handler& handler, bool isKey, size_t offset, std::true_type) {
+    static_assert(!(parseFlags & ParseInsituFlag) || StreamTraits<Stream>::writable,
+                  "In-situ parsing requires a writable stream such as InsituStringStream");
+    const bool insitu = (parseFlags & ParseInsituFlag) != 0;
+
+    // In-situ parsing terminates the string in place, over its closing quotation mark.
+    char_type* head = insitu ? s.begin() : 0;
+
     Stream s_ = s;
+    const char_type* str = s.src_;
+
+    // fast path for strings without escape sequences
+    s_.src_ += ScanString(s_.src_) - s_.src_;
 
-    value_type ret;
+    if (s_.peek() == '\"') {
+      size_type length = (size_type)(s_.src_ - str);
+      s_.take();
+      s = s_;
+      if (insitu)
+        head[length] = '\0';
+
+      reportString<parseFlags>(handler, isKey, str, length, !insitu, offset);
+      return;
+    }
+
+    // decode the rest after the characters scanned so far
+    char_type* dst = 0;
+    if (insitu)
+      dst = head + (s_.src_ - str);
+    else
+      buffer_.assign(str, static_cast<const char_type*>(s_.src_));
 
     while (true) {
       switch (s_.peek()) {
-      case '\"':
-        ret = value_type(s.src_, s_.src_);
+      case '\"': {
         s_.take();
         s = s_;
-        return ret;
-      case '\0': JSONCXX_PARSING_ERROR("Lacks ending quation before the the end of string");
-      case '\\': JSONCXX_PARSING_ERROR("Currently not supported!");
-      default: s_.take(); // normal character
+
+        size_type length = (size_type)(insitu ? dst - head : buffer_.size());
+        if (insitu)
+          *dst = '\0';
+        else
+          buffer_.push_back('\0');
+        const char_type* decoded = insitu ? head : buffer_.data();
+
+        reportString<parseFlags>(handler, isKey, decoded, length, !insitu, offset);
+        return;
+      }
+      case '\0': s = s_; JSONCXX_PARSE_ERROR(ParseErrorStringMissQuotationMark, s.tell());
+      case '\\':
+        s_.take();
+        if (insitu)
+          dst = parseEscape(s_, dst); // decoded characters are never longer than the escape sequence
+        else {
+          char_type decoded[4];
+          char_type* end = parseEscape(s_, decoded);
+          buffer_.insert(buffer_.end(), decoded, end);
+        }
+        if (result_.code != ParseErrorNone) {
+          s = s_;
+          return;
+        }
+        break;
+      default: {
+        if (IsControlCharacter(s_.peek())) {
+          s = s_;
+          JSONCXX_PARSE_ERROR(ParseErrorStringInvalidControlCharacter, s.tell());
+        }
+
+        // copy a run of normal characters at once
+        const char_type* run = s_.src_;
+        s_.src_ += ScanString(s_.src_) - s_.src_;
+        if (insitu) {
+          std::char_traits<char_type>::move(dst, run, s_.src_ - run);
+          dst += s_.src_ - run;
+        } else
+          buffer_.insert(buffer_.end(), run, static_cast<const char_type*>(s_.src_));
+      }
       }
     }
+  }
+
+  //! Parse string by copying its characters to the internal buffer.
+  template <unsigned parseFlags, typename Handler>
+  void parseString(Stream& s, Handler& handler, bool isKey, size_t offset, std::false_type) {
+    static_assert(!(parseFlags & ParseInsituFlag), "In-situ parsing requires a contiguous stream");
+
+    buffer_.clear();
 
-    return ret; // unreachable
+    while (true) {
+      switch (s.peek()) {
+      case '\"': {
+        s.take();
+        size_type length = (size_type)buffer_.size();
+        buffer_.push_back('\0');
+
+        reportString<parseFlags>(handler, isKey, buffer_.data(), length, true, offset);
+        return;
+      }
+      case '\0': JSONCXX_PARSE_ERROR(ParseErrorStringMissQuotationMark, s.tell());
+      case '\\': {
+        s.take();
+        char_type decoded[4];
+        char_type* end = parseEscape(s, decoded);
+        JSONCXX_PARSE_CHECK();
+        buffer_.insert(buffer_.end(), decoded, end);
+        break;
+      }
+      default:
+        if (IsControlCharacter(s.peek()))
+          JSONCXX_PARSE_ERROR(ParseErrorStringInvalidControlCharacter, s.tell());
+        buffer_.push_back(s.take()); // normal character
+      }
+    }
+  }
+
+  //! @brief  Decode an escape sequence following a backslash.
+  //! @param  out Buffer for the decoded characters, which has room for at least 4 characters.
+  //! @return The pointer to the next character after the decoded ones, or out on error.
+  template <typename InputStream>
+  char_type* parseEscape(InputStream& s, char_type* out) {
+    size_t offset = s.tell();
+    char_type e = s.take();
+    switch (e) {
+    case '\"': case '\\': case '/': *out++ = e; return out;
+    case 'b': *out++ = '\b'; return out;
+    case 'f': *out++ = '\f'; return out;
+    case 'n': *out++ = '\n'; return out;
+    case 'r': *out++ = '\r'; return out;
+    case 't': *out++ = '\t'; return out;
+    case 'u': {
+      char32_t codepoint = parseHex4(s);
+      if (result_.code != ParseErrorNone)
+        return out;
+      if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+        // high surrogate must be followed by low surrogate
+        if (s.take() != '\\' || s.take() != 'u')
+          JSONCXX_PARSE_ERROR_RETURN(ParseErrorStringUnicodeSurrogateInvalid, offset, out);
+        char32_t low = parseHex4(s);
+        if (result_.code != ParseErrorNone)
+          return out;
+        if (low < 0xDC00 || low > 0xDFFF)
+          JSONCXX_PARSE_ERROR_RETURN(ParseErrorStringUnicodeSurrogateInvalid, offset, out);
+        codepoint = (((codepoint - 0xD800) << 10) | (low - 0xDC00)) + 0x10000;
+      } else if (codepoint >= 0xDC00 && codepoint <= 0xDFFF)
+        JSONCXX_PARSE_ERROR_RETURN(ParseErrorStringUnicodeSurrogateInvalid, offset, out);
+      return Encoding::Encode(out, codepoint);
+    }
+    default: JSONCXX_PARSE_ERROR_RETURN(ParseErrorStringEscapeInvalid, offset, out);
+    }
+  }
+
+  //! Parse 4 hexadecimal digits of "\u" escape sequence.
+  template <typename InputStream>
+  char32_t parseHex4(InputStream& s) {
+    char32_t codepoint = 0;
+    for (int i = 0; i < 4; i++) {
+      size_t offset = s.tell();
+      char_type c = s.take();
+      codepoint <<= 4;
+      if (c >= '0' && c <= '9')
+        codepoint += c - '0';
+      else if (c >= 'A' && c <= 'F')
+        codepoint += c - 'A' + 10;
+      else if (c >= 'a' && c <= 'f')
+        codepoint += c - 'a' + 10;
+      else
+        JSONCXX_PARSE_ERROR_RETURN(ParseErrorStringUnicodeEscapeInvalidHex, offset, 0);
+    }
+    return codepoint;
   }
 
   //! @}
+
+  //! Array or object open in iterative parsing.
+  struct Frame {
+    explicit Frame(bool object) : object_(object), count_(0) {}
+
+    bool      object_;
+    size_type count_;
+  };
+
+  std::vector<char_type> buffer_; //!< Characters of the string being parsed from a non-contiguous stream.
+  ParseResult            result_; //!< Error of the current parse.
+  std::vector<Frame>     stack_;  //!< Containers open in iterative parsing.
+  size_type              depth_;  //!< Containers open in recursive parsing.
+  size_type              maxDepth_;
 };
 
 }
@@ -0,0 +1,141 @@
+/**
+ *  @file   simd.hpp
+ *  @brief    Detect SIMD instruction sets of the host at runtime.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#ifndef _JSONCXX_SIMD_H_
+#define _JSONCXX_SIMD_H_
+
+//! SIMD kernels are compiled for x86 with function-level target attributes and chosen at runtime,
+//! so a single binary uses the best instruction set of each host.
+//! Define JSONCXX_NO_SIMD to use scalar code only.
+#if !defined(JSONCXX_NO_SIMD) && \
+    (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)) && \
+    (defined(_MSC_VER) || defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define JSONCXX_SIMD
+#endif
+
+#ifdef JSONCXX_SIMD
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>     // __cpuidex, _BitScanForward
+#else
+#include <cpuid.h>      // __cpuid_count
+#endif
+#endif
+
+//! Enable an instruction set for a single function.
+#if defined(JSONCXX_SIMD) && !defined(_MSC_VER)
+#define JSONCXX_TARGET(isa) __attribute__((target(isa)))
+#else
+#define JSONCXX_TARGET(isa)
+#endif
+
+//! Disable address sanitizer for functions which intentionally read whole aligned blocks past the end of string.
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5)
+#define JSONCXX_NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#else
+#define JSONCXX_NO_SANITIZE_ADDRESS
+#endif
+
+namespace jsoncxx {
+
+//! SIMD instruction sets, in increasing order of capability.
+enum SimdLevel {
+  SimdNone,   //!< Scalar code only.
+  SimdSSE2,   //!< SSE2.
+  SimdSSE42,  //!< SSE4.2.
+  SimdAVX2,   //!< AVX2.
+  SimdAVX512, //!< AVX-512 F and BW.
+};
+
+//! Highest instruction set used even if the host supports more, e.g. to avoid AVX-512 frequency drops.
+#ifndef JSONCXX_MAX_SIMD_LEVEL
+#define JSONCXX_MAX_SIMD_LEVEL SimdAVX512
+#endif
+
+#ifdef JSONCXX_SIMD
+//! Detect the best instruction set supported by both the processor and the operating system.
+inline SimdLevel DetectSimdLevel() {
+  unsigned regs[4] = { 0 }; // eax, ebx, ecx, edx
+#ifdef _MSC_VER
+  __cpuidex(reinterpret_cast<int*>(regs), 0, 0);
+#else
+  __cpuid_count(0, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+  unsigned maxLeaf = regs[0];
+
+#ifdef _MSC_VER
+  __cpuidex(reinterpret_cast<int*>(regs), 1, 0);
+#else
+  __cpuid_count(1, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+  const bool sse2 = (regs[3] & (1u << 26)) != 0;
+  const bool sse42 = (regs[2] & (1u << 20)) != 0;
+  const bool osxsave = (regs[2] & (1u << 27)) != 0;
+
+  // registers saved by the operating system on context switch
+  unsigned long long xcr0 = 0;
+  if (osxsave) {
+#ifdef _MSC_VER
+    xcr0 = _xgetbv(0);
+#else
+    unsigned eax, edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    xcr0 = ((unsigned long long)edx << 32) | eax;
+#endif
+  }
+  const bool ymm = (xcr0 & 0x06) == 0x06;
+  const bool zmm = (xcr0 & 0xE6) == 0xE6;
+
+  bool avx2 = false, avx512 = false;
+  if (maxLeaf >= 7) {
+#ifdef _MSC_VER
+    __cpuidex(reinterpret_cast<int*>(regs), 7, 0);
+#else
+    __cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    avx2 = ymm && (regs[1] & (1u << 5)) != 0;
+    avx512 = zmm && (regs[1] & (1u << 16)) != 0 && (regs[1] & (1u << 30)) != 0; // F and BW
+  }
+
+  SimdLevel level = avx512 ? SimdAVX512 : avx2 ? SimdAVX2 : sse42 ? SimdSSE42 : sse2 ? SimdSSE2 : SimdNone;
+  return level < JSONCXX_MAX_SIMD_LEVEL ? level : JSONCXX_MAX_SIMD_LEVEL;
+}
+#else
+inline SimdLevel DetectSimdLevel() {
+  return SimdNone;
+}
+#endif
+
+//! Get the instruction set of the host, which is detected once.
+inline SimdLevel GetSimdLevel() {
+  static const SimdLevel level = DetectSimdLevel();
+  return level;
+}
+
+//! Get the index of the least significant set bit, which must exist.
+inline unsigned CountTrailingZeros(unsigned long long x) {
+#ifdef _MSC_VER
+  unsigned long offset;
+#ifdef _M_X64
+  _BitScanForward64(&offset, x);
+#else
+  if (!_BitScanForward(&offset, (unsigned long)x)) {
+    _BitScanForward(&offset, (unsigned long)(x >> 32));
+    offset += 32;
+  }
+#endif
+  return offset;
+#else
+  return (unsigned)__builtin_ctzll(x);
+#endif
+}
+
+}
+
+#endif // _JSONCXX_SIMD_H_
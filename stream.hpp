@@ -12,6 +12,14 @@
 
 #include "encoding.hpp"
 
+#include <cstring>      // memcpy
+#include <string>
+
+//! Number of readable bytes past the end of an input buffer which SIMD kernels may load.
+#ifndef JSONCXX_SIMD_PADDING
+#define JSONCXX_SIMD_PADDING 64
+#endif
+
 namespace jsoncxx {
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -56,6 +64,20 @@ namespace jsoncxx {
     \endcode
  */
 
+//! Provides additional information for stream.
+/*! By default, a stream is read character by character through peek() and take().
+    Specialize this for streams reading a contiguous in-memory buffer through their src_ member,
+    so that reader can refer to their characters in place instead of copying them,
+    and for streams which can also take decoded characters back, as in-situ parsing requires.
+ */
+template <typename Stream>
+struct StreamTraits {
+  //! Whether the stream reads a contiguous buffer which stays valid during parsing.
+  enum { contiguous = false };
+  //! Whether decoded characters can be written back into the buffer through begin(), put() and end().
+  enum { writable = false };
+};
+
 //! Put N copies of a character to a stream.
 template<typename Stream, typename CharType>
 inline void putN(Stream& stream, CharType c, size_t n) {
@@ -88,6 +110,177 @@ struct StringStream {
   const char_type* head_; //!< Original head of the string.
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// InsituStringStream
+//  Modified by Seonho Oh(seonho.oh@gmail.com)
+//  Original code by
+//    Copyright (c) 2011-2012 Milo Yip (miloyip@gmail.com)
+//
+//! A read-write string stream.
+/*! This string stream is particularly designed for in-situ parsing.
+    Decoded strings are written back into the source buffer, which therefore must be mutable
+    and outlive any value referring to it.
+ */
+template <typename Encoding>
+struct InsituStringStream {
+  typedef typename Encoding::char_type char_type;
+
+  InsituStringStream(char_type *src) : src_(src), dst_(0), head_(src) {}
+
+  // Read
+  inline char_type peek() const { return *src_; }
+  inline char_type take() { return *src_++; }
+  inline size_t tell() const { return src_ - head_; }
+
+  // Write
+  inline char_type* begin() { return dst_ = src_; }
+  inline void put(char_type c) { JSONCXX_ASSERT(dst_ != 0); *dst_++ = c; }
+  inline size_t end(char_type* begin) { return dst_ - begin; }
+
+  char_type* src_;  //!< Current read position.
+  char_type* dst_;  //!< Current write position.
+  char_type* head_; //!< Original head of the string.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// TranscodedStream
+
+//! Read-only string stream over characters converted from another encoding.
+/*! The whole input is converted by Transcoder when the stream is constructed, which converts
+    blocks of UTF-16 and UTF-32 to UTF-8 with SIMD instructions, and the result is read as a StringStream.
+    So a reader of StringStream<TargetEncoding> parses it with all of its fast paths.
+
+    @code
+    jsoncxx::TranscodedStream<jsoncxx::UTF16<> > s(utf16, length);
+    jsoncxx::value v = jsoncxx::reader().parse(s);
+    @endcode
+
+    Offsets reported by tell() count characters of the converted text.
+    \tparam SourceEncoding Encoding of the input.
+    \tparam TargetEncoding Encoding of the stream.
+ */
+template <typename SourceEncoding, typename TargetEncoding = UTF8<> >
+struct TranscodedStream : public StringStream<TargetEncoding> {
+  typedef typename SourceEncoding::char_type source_char_type;
+
+  //! Convert characters.
+  /*! \param src Characters in SourceEncoding.
+      \param length Number of characters.
+   */
+  TranscodedStream(const source_char_type* src, size_t length) : StringStream<TargetEncoding>(0) {
+    valid_ = Transcoder<SourceEncoding, TargetEncoding>::Transcode(src, length, buffer_);
+    this->src_ = this->head_ = buffer_.c_str();
+  }
+
+  //! Check whether the input was well-formed. Ill-formed characters are read as U+FFFD.
+  inline bool valid() const { return valid_; }
+
+ private:
+  TranscodedStream(const TranscodedStream&);
+  TranscodedStream& operator= (const TranscodedStream&);
+
+  std::basic_string<typename TargetEncoding::char_type> buffer_;  //!< Converted characters.
+  bool                                                  valid_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// AutoUTFStream
+
+//! Read-only UTF-8 string stream over bytes in any Unicode encoding scheme, detected by DetectUTF().
+/*! The encoding is detected once when the stream is constructed. UTF-8 is read in place past its
+    byte order mark, and UTF-16 or UTF-32 of either byte order is converted by Transcoder up front.
+    Either way the stream is a StringStream<UTF8<> >, so its reader parses with all of its fast paths.
+
+    @code
+    jsoncxx::MemoryMappedFile<jsoncxx::UTF8<> > file("unknown.json");
+    jsoncxx::AutoUTFStream s(file.data(), file.size());
+    jsoncxx::value v = jsoncxx::reader().parse(s);
+    @endcode
+
+    Offsets reported by tell() count bytes of the UTF-8 text after the byte order mark.
+ */
+struct AutoUTFStream : public StringStream<UTF8<> > {
+  //! Detect the encoding of bytes and convert them if they are not UTF-8.
+  /*! \param data Bytes of the input. UTF-8 input is read in place, so it must be null-terminated like
+      the input of StringStream, and outlive the stream.
+      \param length Number of bytes.
+   */
+  AutoUTFStream(const char* data, size_t length) : StringStream<UTF8<> >(0), valid_(true) {
+    size_t bom;
+    type_ = DetectUTF(data, length, bom);
+    bom_ = bom != 0;
+    data += bom;
+    length -= bom;
+
+    switch (type_) {
+    case UTF8Type:    src_ = head_ = data; return;
+    case UTF16LEType: transcode<UTF16<char16_t> >(data, length, false); break;
+    case UTF16BEType: transcode<UTF16<char16_t> >(data, length, true); break;
+    case UTF32LEType: transcode<UTF32<char32_t> >(data, length, false); break;
+    case UTF32BEType: transcode<UTF32<char32_t> >(data, length, true); break;
+    }
+    src_ = head_ = buffer_.c_str();
+  }
+
+  //! Get the detected encoding.
+  inline UTFType type() const { return type_; }
+
+  //! Check whether the input had a byte order mark.
+  inline bool hasBOM() const { return bom_; }
+
+  //! Check whether converted input was well-formed. Ill-formed characters are read as U+FFFD.
+  /*! UTF-8 input is not checked here; parse it with ParseValidateEncodingFlag for that.
+   */
+  inline bool valid() const { return valid_; }
+
+ private:
+  AutoUTFStream(const AutoUTFStream&);
+  AutoUTFStream& operator= (const AutoUTFStream&);
+
+  static inline char16_t swap(char16_t u) { return static_cast<char16_t>((u >> 8) | (u << 8)); }
+  static inline char32_t swap(char32_t u) {
+    return (u >> 24) | ((u >> 8) & 0xFF00) | ((u << 8) & 0xFF0000) | (u << 24);
+  }
+
+  //! Convert bytes of Encoding to UTF-8. A trailing incomplete unit makes the input ill-formed.
+  template <typename Encoding>
+  void transcode(const char* data, size_t length, bool bigEndian) {
+    typedef typename Encoding::char_type unit_type;
+
+    std::basic_string<unit_type> units(length / sizeof(unit_type), 0);
+    if (!units.empty())
+      memcpy(&units[0], data, units.size() * sizeof(unit_type));
+
+    const unit_type one = 1;
+    if (bigEndian == (*reinterpret_cast<const unsigned char*>(&one) == 1))
+      for (size_t i = 0; i < units.size(); ++i)
+        units[i] = swap(units[i]);
+
+    valid_ = Transcoder<Encoding, UTF8<> >::Transcode(units.data(), units.size(), buffer_) &&
+             length % sizeof(unit_type) == 0;
+  }
+
+  std::string buffer_;  //!< Converted characters, unless the input is UTF-8.
+  UTFType     type_;
+  bool        bom_;
+  bool        valid_;
+};
+
+template <typename Encoding>
+struct StreamTraits<StringStream<Encoding> > {
+  enum { contiguous = true };
+  enum { writable = false };
+};
+
+template <typename Encoding>
+struct StreamTraits<InsituStringStream<Encoding> > {
+  enum { contiguous = true };
+  enum { writable = true };
+};
+
+typedef StringStream<UTF8<> >       stringstream;
+typedef InsituStringStream<UTF8<> > insitustringstream;
+
 }
 
 #endif // _JSONCXX_STREAM_H_
\ No newline at end of file
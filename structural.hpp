@@ -0,0 +1,388 @@
+/**
+ *  @file   structural.hpp
+ *  @brief    Implement two-stage reader over an index of structural characters.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#ifndef _JSONCXX_STRUCTURAL_H_
+#define _JSONCXX_STRUCTURAL_H_
+
+#include "reader.hpp"
+#include "simd.hpp"
+
+#include <cstring>      // memcpy, memset
+#include <vector>
+
+namespace jsoncxx {
+
+///////////////////////////////////////////////////////////////////////////////
+// Block classification
+
+//! Characters of a 64-byte block, one bit per character.
+struct BlockMasks {
+  unsigned long long backslash;   //!< '\\'
+  unsigned long long quote;       //!< '"'
+  unsigned long long op;          //!< '{', '}', '[', ']', ':' and ','
+  unsigned long long whitespace;  //!< ' ', '\\n', '\\r' and '\\t'
+};
+
+//! Classify a 64-byte block one character at a time.
+inline void ClassifyBlock_Scalar(const char* p, BlockMasks& m) {
+  m.backslash = m.quote = m.op = m.whitespace = 0;
+  for (unsigned i = 0; i < 64; ++i) {
+    unsigned long long bit = 1ULL << i;
+    switch (p[i]) {
+    case '\\': m.backslash |= bit; break;
+    case '\"': m.quote |= bit; break;
+    case '{': case '}': case '[': case ']': case ':': case ',': m.op |= bit; break;
+    case ' ': case '\n': case '\r': case '\t': m.whitespace |= bit; break;
+    }
+  }
+}
+
+#ifdef JSONCXX_SIMD
+//! Classify a 64-byte block with SSE2 instructions, 16 characters at a time.
+JSONCXX_TARGET("sse2")
+inline void ClassifyBlock_SSE2(const char* p, BlockMasks& m) {
+  m.backslash = m.quote = m.op = m.whitespace = 0;
+  for (unsigned i = 0; i < 64; i += 16) {
+    __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+    __m128i lower = _mm_or_si128(s, _mm_set1_epi8(0x20)); // '[' -> '{', ']' -> '}'
+    __m128i op = _mm_or_si128(_mm_cmpeq_epi8(lower, _mm_set1_epi8('{')), _mm_cmpeq_epi8(lower, _mm_set1_epi8('}')));
+    op = _mm_or_si128(op, _mm_or_si128(_mm_cmpeq_epi8(s, _mm_set1_epi8(':')), _mm_cmpeq_epi8(s, _mm_set1_epi8(','))));
+    __m128i ws = _mm_or_si128(_mm_cmpeq_epi8(s, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(s, _mm_set1_epi8('\n')));
+    ws = _mm_or_si128(ws, _mm_or_si128(_mm_cmpeq_epi8(s, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(s, _mm_set1_epi8('\t'))));
+
+    m.backslash   |= (unsigned long long)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(s, _mm_set1_epi8('\\'))) << i;
+    m.quote       |= (unsigned long long)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(s, _mm_set1_epi8('\"'))) << i;
+    m.op          |= (unsigned long long)(unsigned)_mm_movemask_epi8(op) << i;
+    m.whitespace  |= (unsigned long long)(unsigned)_mm_movemask_epi8(ws) << i;
+  }
+}
+
+//! Classify a 64-byte block with AVX2 instructions, 32 characters at a time.
+JSONCXX_TARGET("avx2")
+inline void ClassifyBlock_AVX2(const char* p, BlockMasks& m) {
+  m.backslash = m.quote = m.op = m.whitespace = 0;
+  for (unsigned i = 0; i < 64; i += 32) {
+    __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+    __m256i lower = _mm256_or_si256(s, _mm256_set1_epi8(0x20)); // '[' -> '{', ']' -> '}'
+    __m256i op = _mm256_or_si256(_mm256_cmpeq_epi8(lower, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('}')));
+    op = _mm256_or_si256(op, _mm256_or_si256(_mm256_cmpeq_epi8(s, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(s, _mm256_set1_epi8(','))));
+    __m256i ws = _mm256_or_si256(_mm256_cmpeq_epi8(s, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(s, _mm256_set1_epi8('\n')));
+    ws = _mm256_or_si256(ws, _mm256_or_si256(_mm256_cmpeq_epi8(s, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(s, _mm256_set1_epi8('\t'))));
+
+    m.backslash   |= (unsigned long long)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(s, _mm256_set1_epi8('\\'))) << i;
+    m.quote       |= (unsigned long long)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(s, _mm256_set1_epi8('\"'))) << i;
+    m.op          |= (unsigned long long)(unsigned)_mm256_movemask_epi8(op) << i;
+    m.whitespace  |= (unsigned long long)(unsigned)_mm256_movemask_epi8(ws) << i;
+  }
+}
+#endif // JSONCXX_SIMD
+
+//! Select the best kernel for classifying blocks on the host.
+inline void (*SelectClassifyBlock())(const char*, BlockMasks&) {
+  switch (GetSimdLevel()) {
+#ifdef JSONCXX_SIMD
+  case SimdAVX512:
+  case SimdAVX2:    return &ClassifyBlock_AVX2;
+  case SimdSSE42:
+  case SimdSSE2:    return &ClassifyBlock_SSE2;
+#endif
+  default:          return &ClassifyBlock_Scalar;
+  }
+}
+
+//! Compute the running parity of bits from the least significant one.
+inline unsigned long long PrefixXor(unsigned long long x) {
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// StructuralIndex
+
+//! Positions of the tokens of a document, found without parsing it.
+/*! A token is a structural character ({, }, [, ], : or ,), the opening quotation mark of a string,
+    or the first character of a number or literal. Characters inside strings are never tokens.
+
+    The document is classified 64 characters at a time into bitmaps with SIMD instructions,
+    and strings are masked out with bitwise arithmetic, so there is no branch per character.
+    The last position is the length of the document, which serves as a sentinel.
+
+    Positions are stored as size_type, so documents are limited to 4 GB.
+    \tparam Encoding Encoding of the document. Its character must be a byte.
+ */
+template <typename Encoding = UTF8<> >
+class StructuralIndex {
+ public:
+  typedef typename Encoding::char_type      char_type;
+  typedef const size_type*                  const_iterator;
+
+  static_assert(sizeof(char_type) == 1, "StructuralIndex requires a byte encoding");
+
+  StructuralIndex() : size_(0) {}
+
+  //! Index a document.
+  /*! \param json Characters of the document.
+      \param length Number of characters.
+   */
+  void build(const char_type* json, size_t length) {
+    static void (*const classify)(const char*, BlockMasks&) = SelectClassifyBlock();
+
+    // Every character may start a token, plus the sentinel. The buffer only grows, so it is not cleared again.
+    if (positions_.size() < length + 1)
+      positions_.resize(length + 1);
+    size_type* out = positions_.data();
+    prevEscaped_ = prevInString_ = prevScalar_ = 0;
+
+    const char* p = reinterpret_cast<const char*>(json);
+    BlockMasks masks;
+    size_t i = 0;
+    for (; i + 64 <= length; i += 64) {
+      classify(p + i, masks);
+      out = flatten(structurals(masks), (size_type)i, out);
+    }
+
+    if (i < length) {
+      // Pad the last block with white spaces, which are never tokens.
+      char block[64];
+      std::memset(block, ' ', sizeof(block));
+      std::memcpy(block, p + i, length - i);
+      classify(block, masks);
+      out = flatten(structurals(masks), (size_type)i, out);
+    }
+
+    if (prevInString_)
+      JSONCXX_PARSING_ERROR("Lacks ending quation before the the end of string");
+
+    *out++ = (size_type)length;
+    size_ = out - positions_.data();
+  }
+
+  inline const_iterator begin() const           { return positions_.data(); }
+  inline const_iterator end() const             { return positions_.data() + size_; }
+
+  //! Get the number of positions including the sentinel.
+  inline size_t size() const                    { return size_; }
+  inline size_type operator[] (size_t i) const  { return positions_[i]; }
+
+ private:
+  //! Find the tokens of a block, carrying the state of strings to the next block.
+  unsigned long long structurals(const BlockMasks& m) {
+    // Characters escaped by a backslash. A run of backslashes escapes the character after it
+    // only if the run has odd length, so runs are split by the parity of their first bit.
+    const unsigned long long even = 0x5555555555555555ULL;
+    unsigned long long backslash = m.backslash & ~prevEscaped_;
+    unsigned long long followsEscape = (backslash << 1) | prevEscaped_;
+    unsigned long long oddStarts = backslash & ~even & ~followsEscape;
+    unsigned long long evenRuns = oddStarts + backslash;
+    prevEscaped_ = evenRuns < oddStarts ? 1 : 0;  // carry out of the block
+    unsigned long long escaped = (even ^ (evenRuns << 1)) & followsEscape;
+
+    // Inside of strings, including the opening quotation mark but not the closing one.
+    unsigned long long quote = m.quote & ~escaped;
+    unsigned long long inString = PrefixXor(quote) ^ prevInString_;
+    prevInString_ = (inString >> 63) ? ~0ULL : 0;
+
+    // Numbers and literals start at a character which does not follow another one of them.
+    unsigned long long scalar = ~(m.op | m.whitespace);
+    unsigned long long nonQuoteScalar = scalar & ~quote;
+    unsigned long long followsScalar = (nonQuoteScalar << 1) | prevScalar_;
+    prevScalar_ = nonQuoteScalar >> 63;
+
+    return (m.op | (scalar & ~followsScalar)) & ~(inString ^ quote);
+  }
+
+  //! Append positions of set bits.
+  static size_type* flatten(unsigned long long bits, size_type base, size_type* out) {
+    while (bits) {
+      *out++ = base + CountTrailingZeros(bits);
+      bits &= bits - 1;
+    }
+    return out;
+  }
+
+  std::vector<size_type>  positions_;
+  size_t                  size_;          //!< Number of positions in use.
+  unsigned long long      prevEscaped_;   //!< Whether the first character of the next block is escaped.
+  unsigned long long      prevInString_;  //!< All bits set if the next block starts inside a string.
+  unsigned long long      prevScalar_;    //!< Whether the last character was part of a number or literal.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// StructuralReader
+
+//! Two-stage reader for large documents in memory.
+/*! Stage one builds a StructuralIndex of the whole document. Stage two walks the index with
+    an explicit stack, so the grammar is checked once per token instead of once per character,
+    and each string, number and literal is parsed by Reader at its known position.
+
+    Events are the same as Reader's, so any Handler works with it.
+
+    @code
+    jsoncxx::StructuralReader<> reader;
+    jsoncxx::value root = reader.parse(file.data(), file.size());
+    @endcode
+
+    \tparam Encoding Encoding of the document. Its character must be a byte.
+ */
+template <typename Encoding = UTF8<> >
+class StructuralReader {
+ public:
+  typedef typename Encoding::char_type  char_type;
+  typedef Value<Encoding>               value_type;
+
+  //! Parse a document into a value.
+  /*! \param json Characters of the document, which must be followed by a null character.
+      \param length Number of characters.
+   */
+  value_type parse(const char_type* json, size_t length) {
+    ValueHandler<Encoding> handler;
+    parse(json, length, handler);
+    return handler.release();
+  }
+
+  //! Parse a null-terminated document into a value.
+  value_type parse(const char_type* json) {
+    return parse(json, std::char_traits<char_type>::length(json));
+  }
+
+  //! Parse a document and report it to handler.
+  template <typename Handler>
+  void parse(const char_type* json, size_t length, Handler& handler) {
+    index_.build(json, length);
+    json_ = json;
+
+    const size_type* p = index_.begin();
+    const size_type* last = index_.end() - 1;  // sentinel
+    stack_.clear();
+
+    for (;;) {
+      // at a value
+      switch (json[*p]) {
+      case '{':
+        handler.startObject();
+        if (json[*++p] == '}') {
+          handler.endObject(0);
+          ++p;
+          break;
+        }
+        stack_.push_back(Frame(true));
+        p = parseKey(p, handler);
+        continue;
+      case '[':
+        handler.startArray();
+        if (json[*++p] == ']') {
+          handler.endArray(0);
+          ++p;
+          break;
+        }
+        stack_.push_back(Frame(false));
+        continue;
+      case '}': case ']': case ':': case ',':
+        JSONCXX_PARSING_ERROR("Invalid value");
+      case '\0':
+        if (p == last)
+          JSONCXX_PARSING_ERROR("Unexpected end of input");
+        JSONCXX_PARSING_ERROR("Invalid value");
+      default:
+        p = parseToken(p, handler);
+      }
+
+      // after a value, close the containers it completes
+      for (;;) {
+        if (stack_.empty()) {
+          if (p != last)
+            JSONCXX_PARSING_ERROR("The document root must not be followed by other values");
+          return;
+        }
+
+        Frame& frame = stack_.back();
+        ++frame.count_;
+        char_type c = json[*p++];
+        if (c == ',') {
+          if (frame.object_)
+            p = parseKey(p, handler);
+          break;
+        }
+
+        if (frame.object_) {
+          if (c != '}')
+            JSONCXX_PARSING_ERROR("Must be a comma or '}' after an object member");
+          handler.endObject(frame.count_);
+        } else {
+          if (c != ']')
+            JSONCXX_PARSING_ERROR("Must be a comma or ']' after an array member");
+          handler.endArray(frame.count_);
+        }
+        stack_.pop_back();
+      }
+    }
+  }
+
+  //! Get the index of the last document.
+  inline const StructuralIndex<Encoding>& index() const { return index_; }
+
+ private:
+  //! Container being parsed.
+  struct Frame {
+    explicit Frame(bool object) : object_(object), count_(0) {}
+
+    bool      object_;
+    size_type count_;
+  };
+
+  //! Parse the name of an object member and the following colon.
+  template <typename Handler>
+  const size_type* parseKey(const size_type* p, Handler& handler) {
+    if (json_[*p] != '"')
+      JSONCXX_PARSING_ERROR("Name of an object member must be a string");
+
+    KeyHandler<Handler, Encoding> keyHandler(handler);
+    p = parseToken(p, keyHandler);
+
+    if (json_[*p] != ':')
+      JSONCXX_PARSING_ERROR("There must be a colon after the name of object member");
+    return p + 1;
+  }
+
+  //! Parse a string, number or literal, which must end right before the next token.
+  template <typename Handler>
+  const size_type* parseToken(const size_type* p, Handler& handler) {
+    const char_type* head = json_ + *p;
+    if (*head == '"') {
+      // Most strings have no escape, and the characters after them up to the next token are white spaces.
+      const char_type* tail = ScanString(head + 1);
+      if (*tail == '"') {
+        handler.string(head + 1, (size_type)(tail - head - 1), true);
+        return p + 1;
+      }
+    }
+
+    StringStream<Encoding> s(head);
+    reader_.parse(s, handler);
+    // The token is followed by a white space or the next token, otherwise the rest of it was not parsed.
+    size_type tail = *p + (size_type)s.tell();
+    if (tail != p[1] && !IsWhitespace(json_[tail]))
+      JSONCXX_PARSING_ERROR("Invalid value");
+    return p + 1;
+  }
+
+  StructuralIndex<Encoding>                 index_;
+  Reader<StringStream<Encoding>, Encoding>  reader_;  //!< Reader parsing strings, numbers and literals.
+  std::vector<Frame>                        stack_;   //!< Containers being parsed.
+  const char_type*                          json_;
+};
+
+}
+
+#endif // _JSONCXX_STRUCTURAL_H_
@@ -0,0 +1,383 @@
+/**
+ *  @file   tape.hpp
+ *  @brief    Implement compact read-only document stored in a flat tape.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#ifndef _JSONCXX_TAPE_H_
+#define _JSONCXX_TAPE_H_
+
+#include "reader.hpp"
+
+#include <cstring>      // memcpy
+#include <iterator>
+#include <vector>
+
+namespace jsoncxx {
+
+template <typename Encoding> class TapeDocument;
+template <typename Encoding> class TapeHandler;
+
+//! Cursor to a value in a TapeDocument.
+/*! A cursor is the index of a word in the tape, so it is as cheap to copy as a pointer.
+    Accessors have the same names as those of Value, and strings are returned as references to the string arena.
+    A cursor is valid as long as its document.
+    \tparam Encoding Encoding of the document.
+ */
+template <typename Encoding = UTF8<> >
+class TapeValue {
+ public:
+  typedef typename Encoding::char_type  char_type;
+  typedef StringRef<char_type>          string_ref;
+  typedef TapeValue<Encoding>           self_type;
+  typedef TapeDocument<Encoding>        document_type;
+
+  //! Iterator over the elements of an array or the members of an object.
+  class const_iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef self_type                 value_type;
+    typedef std::ptrdiff_t            difference_type;
+    typedef const self_type*          pointer;
+    typedef self_type                 reference;
+
+    const_iterator() : doc_(0), index_(0), object_(false) {}
+
+    //! Get the element, or the value of the member.
+    inline self_type operator* () const { return self_type(doc_, object_ ? index_ + 1 : index_); }
+
+    //! Get the name of the member.
+    inline string_ref key() const {
+      JSONCXX_ASSERT(object_);
+      return self_type(doc_, index_).asString();
+    }
+
+    inline const_iterator& operator++ () {
+      index_ = doc_->next(object_ ? index_ + 1 : index_);
+      return *this;
+    }
+
+    inline const_iterator operator++ (int) { const_iterator itr = *this; ++(*this); return itr; }
+
+    inline bool operator == (const const_iterator& other) const { return index_ == other.index_; }
+    inline bool operator != (const const_iterator& other) const { return index_ != other.index_; }
+
+   private:
+    friend class TapeValue;
+
+    const_iterator(const document_type* doc, size_t index, bool object)
+      : doc_(doc), index_(index), object_(object) {}
+
+    const document_type* doc_;
+    size_t               index_;  //!< Word of the element or the name of the member.
+    bool                 object_;
+  };
+
+  TapeValue() : doc_(0), index_(0) {}
+
+  //! Check whether the value is present, which is false for a missing member or element.
+  inline bool exists() const            { return doc_ != 0; }
+
+  //! Get type of value. A missing value is null.
+  ValueType type() const {
+    if (!exists())
+      return NullType;
+
+    switch (tag()) {
+    case 't': return TrueType;
+    case 'f': return FalseType;
+    case '"': return StringType;
+    case '{': return ObjectType;
+    case '[': return ArrayType;
+    case 'l': case 'd': return NumberType;
+    default:  return NullType;
+    }
+  }
+
+  //! @name Property functions.
+  //! @{
+
+  inline bool asBool() const {
+    JSONCXX_ASSERT(tag() == 't' || tag() == 'f');
+    return tag() == 't';
+  }
+
+  //! Get string value, which refers to the string arena of the document and is null-terminated.
+  inline string_ref asString() const {
+    JSONCXX_ASSERT(tag() == '"');
+    const char_type* str = &doc_->strings_[payload()];
+    size_type length;
+    std::memcpy(&length, str, sizeof(length));
+    return string_ref(str + document_type::lengthChars, length);
+  }
+
+  inline natural asNatural() const {
+    JSONCXX_ASSERT(tag() == 'l' || tag() == 'd');
+    if (tag() == 'l')
+      return static_cast<natural>(doc_->tape_[index_ + 1]);
+    return static_cast<natural>(realValue());
+  }
+
+  inline real asReal() const {
+    JSONCXX_ASSERT(tag() == 'l' || tag() == 'd');
+    if (tag() == 'd')
+      return realValue();
+    return static_cast<real>(static_cast<natural>(doc_->tape_[index_ + 1]));
+  }
+
+  //! Get the number of elements or members. Other values have none.
+  size_type size() const {
+    if (!isContainer())
+      return 0;
+    size_type count = static_cast<size_type>(payload() >> 32);
+    if (count == (size_type)document_type::maxCount) { // saturated, count by walking
+      count = 0;
+      for (const_iterator itr = begin(); itr != end(); ++itr)
+        ++count;
+    }
+    return count;
+  }
+
+  inline bool empty() const { return begin() == end(); }
+
+  //! @}
+
+  //! @name Container functions.
+  //! @{
+
+  //! Get the first element or member. A missing value or a value which is not a container is empty.
+  inline const_iterator begin() const {
+    if (!isContainer())
+      return end();
+    return const_iterator(doc_, index_ + 1, tag() == '{');
+  }
+
+  //! The end of a container is the word of its closing bracket.
+  inline const_iterator end() const {
+    if (!isContainer())
+      return const_iterator(doc_, 0, false);
+    return const_iterator(doc_, (payload() & 0xFFFFFFFFULL) - 1, tag() == '{');
+  }
+
+  //! Access array element by index.
+  /*! A missing element is returned past the end, or if the value is missing or not an array,
+      so lookups can be chained and checked once with exists().
+   */
+  self_type operator [] (size_type index) const {
+    if (!exists() || tag() != '[')
+      return self_type();
+    for (const_iterator itr = begin(); itr != end(); ++itr, --index)
+      if (index == 0)
+        return *itr;
+    return self_type();
+  }
+
+  //! Access object member by name.
+  /*! A missing member is returned if there is none, or if the value is missing or not an object.
+   */
+  self_type operator [] (const string_ref& key) const {
+    if (!exists() || tag() != '{')
+      return self_type();
+    for (const_iterator itr = begin(); itr != end(); ++itr)
+      if (itr.key() == key)
+        return *itr;
+    return self_type();
+  }
+
+  //! @}
+
+ private:
+  friend class TapeDocument<Encoding>;
+
+  TapeValue(const document_type* doc, size_t index) : doc_(doc), index_(index) {}
+
+  inline char tag() const                   { return document_type::tag(doc_->tape_[index_]); }
+  inline bool isContainer() const           { return exists() && (tag() == '{' || tag() == '['); }
+  inline unsigned long long payload() const { return document_type::payload(doc_->tape_[index_]); }
+
+  inline real realValue() const {
+    real r;
+    std::memcpy(&r, &doc_->tape_[index_ + 1], sizeof(r));
+    return r;
+  }
+
+  const document_type*  doc_;
+  size_t                index_;
+};
+
+//! Compact read-only document.
+/*! A parsed document lives in a tape of 64-bit words and an arena of strings,
+    instead of a tree of separately allocated values, so reading it is cache-friendly
+    and freeing it releases two buffers.
+
+    Each value is one word tagged with a character in the highest byte:
+    - 'n', 't', 'f': null, true and false.
+    - 'l', 'd': natural and real number, followed by a word holding the number.
+    - '"': string, whose payload is the offset of its length and characters in the string arena.
+      Names of object members are strings too, followed by their values.
+    - '{', '[': start of a container, whose payload holds the number of members or elements (saturating, 24 bits)
+      and the index of the word after the closing bracket, so a container is skipped at once.
+    - '}', ']': end of a container, whose payload is the index of its opening bracket.
+
+    The tape is filled by TapeHandler, so a document can be built by any reader.
+
+    @code
+    jsoncxx::TapeDocument<> doc;
+    doc.parse(json);
+    jsoncxx::TapeValue<> name = doc.root()["user"]["name"];
+    if (name.type() == jsoncxx::StringType)
+      std::cout << name.asString() << std::endl;
+    @endcode
+
+    \tparam Encoding Encoding of the document.
+ */
+template <typename Encoding = UTF8<> >
+class TapeDocument {
+ public:
+  typedef typename Encoding::char_type  char_type;
+  typedef TapeValue<Encoding>           tape_value;
+
+  //! Parse a value from stream into the document, replacing the previous one.
+  /*! On error, the document is left empty and the exception is rethrown.
+   */
+  template <unsigned parseFlags = ParseDefaultFlags, typename Stream>
+  void parse(Stream& s) {
+    TapeHandler<Encoding> handler(*this);
+    try {
+      Reader<Stream, Encoding>().template parse<parseFlags>(s, handler);
+    } catch (...) {
+      clear();  // the tape has containers without their ends
+      throw;
+    }
+  }
+
+  //! Parse a null-terminated string into the document, replacing the previous one.
+  void parse(const char_type* json) {
+    StringStream<Encoding> s(json);
+    parse(s);
+  }
+
+  //! Get the root value, which is missing if the document is empty.
+  inline tape_value root() const {
+    if (tape_.empty())
+      return tape_value();
+    return tape_value(this, 0);
+  }
+
+  //! Check whether the document holds no value, e.g. after a failed parse.
+  inline bool empty() const { return tape_.empty(); }
+
+  //! Remove the document, keeping buffers for the next one.
+  void clear() {
+    tape_.clear();
+    strings_.clear();
+  }
+
+  //! Get the number of words in the tape.
+  inline size_t tapeSize() const { return tape_.size(); }
+
+ private:
+  friend class TapeValue<Encoding>;
+  friend class TapeHandler<Encoding>;
+
+  enum {
+    lengthChars = (sizeof(size_type) + sizeof(char_type) - 1) / sizeof(char_type), //!< Characters holding the length of a string.
+    maxCount    = 0xFFFFFF,   //!< Count of a container which does not fit in its word.
+  };
+
+  static inline unsigned long long word(char tag, unsigned long long payload) {
+    return (static_cast<unsigned long long>(static_cast<unsigned char>(tag)) << 56) | payload;
+  }
+  static inline char tag(unsigned long long word)                 { return static_cast<char>(word >> 56); }
+  static inline unsigned long long payload(unsigned long long word) { return word & 0x00FFFFFFFFFFFFFFULL; }
+
+  //! Get the index of the word after a value.
+  inline size_t next(size_t index) const {
+    switch (tag(tape_[index])) {
+    case '{': case '[': return static_cast<size_t>(payload(tape_[index]) & 0xFFFFFFFFULL);
+    case 'l': case 'd': return index + 2;
+    default:            return index + 1;
+    }
+  }
+
+  std::vector<unsigned long long> tape_;
+  std::vector<char_type>          strings_; //!< Length and null-terminated characters of each string.
+};
+
+//! Handler which appends the events of a reader to the tape of a TapeDocument.
+/*! The document is cleared on construction.
+ */
+template <typename Encoding = UTF8<> >
+class TapeHandler {
+ public:
+  typedef typename Encoding::char_type  char_type;
+  typedef TapeDocument<Encoding>        document_type;
+
+  explicit TapeHandler(document_type& doc) : doc_(doc) {
+    doc_.clear();
+  }
+
+  void null()                 { append('n', 0); }
+  void boolean(bool b)        { append(b ? 't' : 'f', 0); }
+
+  void number(natural n) {
+    append('l', 0);
+    doc_.tape_.push_back(static_cast<unsigned long long>(n));
+  }
+
+  void number(real r) {
+    unsigned long long bits;
+    std::memcpy(&bits, &r, sizeof(bits));
+    append('d', 0);
+    doc_.tape_.push_back(bits);
+  }
+
+  void string(const char_type* str, size_type length, bool) {
+    std::vector<char_type>& strings = doc_.strings_;
+    size_t offset = strings.size();
+    strings.resize(offset + document_type::lengthChars + length + 1);
+    std::memcpy(&strings[offset], &length, sizeof(length));
+    std::char_traits<char_type>::copy(&strings[offset + document_type::lengthChars], str, length);
+    strings.back() = 0;
+    append('"', offset);
+  }
+
+  void startObject()          { start('{'); }
+  void key(const char_type* str, size_type length, bool copy) { string(str, length, copy); }
+  void endObject(size_type memberCount) { end('{', '}', memberCount); }
+
+  void startArray()           { start('['); }
+  void endArray(size_type elementCount) { end('[', ']', elementCount); }
+
+ private:
+  inline void append(char tag, unsigned long long payload) {
+    doc_.tape_.push_back(document_type::word(tag, payload));
+  }
+
+  void start(char tag) {
+    stack_.push_back(doc_.tape_.size());
+    append(tag, 0);
+  }
+
+  //! Close a container and point its opening word past the closing one.
+  void end(char open, char close, size_type count) {
+    size_t start = stack_.back();
+    stack_.pop_back();
+    append(close, start);
+
+    size_t after = doc_.tape_.size();
+    JSONCXX_ASSERT(after <= 0xFFFFFFFFULL);
+    unsigned long long saturated = count < (size_type)document_type::maxCount ? count : (size_type)document_type::maxCount;
+    doc_.tape_[start] = document_type::word(open, (saturated << 32) | after);
+  }
+
+  document_type&      doc_;
+  std::vector<size_t> stack_; //!< Words of the open containers.
+};
+
+}
+
+#endif // _JSONCXX_TAPE_H_
@@ -0,0 +1,164 @@
+/**
+ *  @file   autoutf.cpp
+ *  @brief    Test driver of DetectUTF and AutoUTFStream.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#include "jsoncxx.hpp"
+#include "check.hpp"
+
+#include <sstream>
+#include <string>
+
+using namespace jsoncxx;
+
+static const UTFType types[] = { UTF8Type, UTF16LEType, UTF16BEType, UTF32LEType, UTF32BEType };
+
+//! Encode characters in an encoding scheme, with or without its byte order mark.
+static std::string encode(const std::u32string& chars, UTFType type, bool bom) {
+  std::string bytes;
+  if (type == UTF8Type) {
+    Transcoder<UTF32<char32_t>, UTF8<char> >::Transcode(chars.data(), chars.size(), bytes);
+    return bom ? "\xEF\xBB\xBF" + bytes : bytes;
+  }
+
+  std::u32string units;
+  if (bom)
+    units += U'\xFEFF';
+  for (size_t i = 0; i < chars.size(); ++i) {
+    if ((type == UTF16LEType || type == UTF16BEType) && chars[i] >= 0x10000) {
+      units += (char32_t)(0xD800 + ((chars[i] - 0x10000) >> 10));
+      units += (char32_t)(0xDC00 + ((chars[i] - 0x10000) & 0x3FF));
+    } else
+      units += chars[i];
+  }
+
+  const size_t size = type == UTF16LEType || type == UTF16BEType ? 2 : 4;
+  const bool bigEndian = type == UTF16BEType || type == UTF32BEType;
+  for (size_t i = 0; i < units.size(); ++i)
+    for (size_t j = 0; j < size; ++j)
+      bytes += (char)(units[i] >> (8 * (bigEndian ? size - 1 - j : j)) & 0xFF);
+  return bytes;
+}
+
+static std::string print(const value& v) {
+  std::ostringstream os;
+  os << v;
+  return os.str();
+}
+
+//! Every scheme is told by its byte order mark, and without it by the null bytes of the first characters.
+static void testDetect() {
+  const size_t boms[] = { 3, 2, 2, 4, 4 };
+  for (size_t i = 0; i < 5; ++i) {
+    size_t bom = 99;
+    std::string marked = encode(U"[1]", types[i], true);
+    JSONCXX_CHECK(DetectUTF(marked.data(), marked.size(), bom) == types[i] && bom == boms[i]);
+
+    std::string unmarked = encode(U"{\"a\": 1}", types[i], false);
+    JSONCXX_CHECK(DetectUTF(unmarked.data(), unmarked.size(), bom) == types[i] && bom == 0);
+
+    // a document of a single character is told by its nulls too
+    std::string digit = encode(U"7", types[i], false);
+    JSONCXX_CHECK(DetectUTF(digit.data(), digit.size(), bom) == types[i] && bom == 0);
+  }
+
+  // the byte order mark of UTF-32LE starts with that of UTF-16LE
+  size_t bom;
+  JSONCXX_CHECK(DetectUTF("\xFF\xFE\x00\x00", 4, bom) == UTF32LEType && bom == 4);
+  JSONCXX_CHECK(DetectUTF("\xFF\xFE" "1\x00", 4, bom) == UTF16LEType && bom == 2);
+}
+
+//! Inputs of 0 to 3 bytes, which are too short for some of the byte order marks and null patterns.
+static void testShortInputs() {
+  struct Case {
+    const char* bytes;
+    size_t      length;
+    UTFType     type;
+    size_t      bom;
+    bool        valid;
+  } cases[] = {
+    { "",             0, UTF8Type,    0, true },
+    { "1",            1, UTF8Type,    0, true },
+    { "\x00",         1, UTF8Type,    0, true },
+    { "\xFF",         1, UTF8Type,    0, true },
+    { "[]",           2, UTF8Type,    0, true },
+    { "1\x00",        2, UTF16LEType, 0, true },
+    { "\x00" "1",     2, UTF16BEType, 0, true },
+    { "\xFF\xFE",     2, UTF16LEType, 2, true },
+    { "\xFE\xFF",     2, UTF16BEType, 2, true },
+    { "\xEF\xBB",     2, UTF8Type,    0, true },
+    { "\xEF\xBB\xBF", 3, UTF8Type,    3, true },
+    { "\xFF\xFE\x00", 3, UTF16LEType, 2, false },
+    { "1\x00\x00",    3, UTF16LEType, 0, false },
+    { "\x00\x00\xFE", 3, UTF8Type,    0, true },
+  };
+
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+    size_t bom;
+    JSONCXX_CHECK(DetectUTF(cases[i].bytes, cases[i].length, bom) == cases[i].type && bom == cases[i].bom);
+
+    AutoUTFStream s(cases[i].bytes, cases[i].length);
+    JSONCXX_CHECK(s.type() == cases[i].type && s.hasBOM() == (cases[i].bom != 0));
+    JSONCXX_CHECK(s.valid() == cases[i].valid);
+  }
+
+  AutoUTFStream digit("1\x00", 2);
+  JSONCXX_CHECK(reader().parse(digit).asNatural() == 1);
+}
+
+//! A trailing byte of an incomplete unit, and ill-formed units, make converted input invalid.
+static void testIllFormed() {
+  for (size_t i = 1; i < 5; ++i) {
+    std::string bytes = encode(U"[\"é\"]", types[i], i % 2 == 0);
+    AutoUTFStream whole(bytes.data(), bytes.size());
+    JSONCXX_CHECK(whole.valid());
+
+    bytes += 'x';
+    AutoUTFStream odd(bytes.data(), bytes.size());
+    JSONCXX_CHECK(odd.type() == types[i] && !odd.valid());
+  }
+
+  // a lone surrogate is read as U+FFFD
+  std::string lone = encode(U"[\"a\"]", UTF16LEType, false);
+  lone[4] = '\x00';
+  lone[5] = '\xD8';
+  AutoUTFStream s(lone.data(), lone.size());
+  JSONCXX_CHECK(!s.valid());
+  JSONCXX_CHECK(reader().parse(s)[size_t(0)].asString() == "\xEF\xBF\xBD");
+}
+
+//! A document parses to the same value in every scheme and byte order, with or without byte order mark.
+static void testRoundTrip() {
+  const std::u32string document =
+    U"{\"name\": \"café € \U0001F600\", \"list\": [1, -2.5, true, null, \"�\"], \"empty\": {}}";
+  const std::string utf8 = encode(document, UTF8Type, false);
+  stringstream plain(utf8.c_str());
+  const std::string expected = print(reader().parse(plain));
+
+  for (size_t i = 0; i < 5; ++i) {
+    for (int bom = 0; bom < 2; ++bom) {
+      std::string bytes = encode(document, types[i], bom != 0);
+      AutoUTFStream s(bytes.c_str(), bytes.size());
+      JSONCXX_CHECK(s.type() == types[i] && s.hasBOM() == (bom != 0) && s.valid());
+      JSONCXX_CHECK(s.tell() == 0);
+      JSONCXX_CHECK(print(reader().parse(s)) == expected);
+    }
+  }
+
+  // UTF-8 is read in place past its byte order mark
+  std::string marked = "\xEF\xBB\xBF" + utf8;
+  AutoUTFStream s(marked.c_str(), marked.size());
+  JSONCXX_CHECK(s.src_ == marked.c_str() + 3);
+}
+
+int main() {
+  testDetect();
+  testShortInputs();
+  testIllFormed();
+  testRoundTrip();
+  return report("autoutf");
+}
@@ -0,0 +1,182 @@
+/**
+ *  @file   binding.cpp
+ *  @brief    Test driver of BindReader.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#include "jsoncxx.hpp"
+#include "check.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+struct Point {
+  int x, y;
+  std::string label;
+  std::vector<Point> children;
+};
+
+struct Flags {
+  std::vector<bool>               bits;
+  std::vector<std::vector<int> >  grid;
+  std::vector<std::string>        names;
+  std::vector<jsoncxx::value>     values;
+};
+
+struct Limits {
+  int8_t    i8;
+  uint8_t   u8;
+  int64_t   i64;
+  uint64_t  u64;
+  float     f;
+  double    d;
+};
+
+namespace jsoncxx {
+template <> struct Binding<Point> {
+  template <typename Visitor>
+  static void fields(Visitor& visit) {
+    visit("x", &Point::x);
+    visit("y", &Point::y);
+    visit("label", &Point::label);
+    visit("children", &Point::children);
+  }
+};
+
+template <> struct Binding<Flags> {
+  template <typename Visitor>
+  static void fields(Visitor& visit) {
+    visit("bits", &Flags::bits);
+    visit("grid", &Flags::grid);
+    visit("names", &Flags::names);
+    visit("values", &Flags::values);
+  }
+};
+
+template <> struct Binding<Limits> {
+  template <typename Visitor>
+  static void fields(Visitor& visit) {
+    visit("i8", &Limits::i8);
+    visit("u8", &Limits::u8);
+    visit("i64", &Limits::i64);
+    visit("u64", &Limits::u64);
+    visit("f", &Limits::f);
+    visit("d", &Limits::d);
+  }
+};
+}
+
+using namespace jsoncxx;
+
+typedef StringStream<UTF8<> > Stream;
+
+template <typename T>
+static void bind(const char* json, T& obj) {
+  Stream s(json);
+  BindReader<Stream>().parse(s, obj);
+}
+
+//! Structs nest in vectors of themselves, to any depth the reader allows.
+static void testNested() {
+  Point point;
+  bind("{\"x\": 1, \"y\": -2, \"label\": \"root\","
+       " \"children\": [{\"x\": 3, \"y\": 4, \"label\": \"leaf\", \"children\": [{\"label\": \"e\\\"scaped\"}]}]}", point);
+  JSONCXX_CHECK(point.x == 1 && point.y == -2 && point.label == "root");
+  JSONCXX_CHECK(point.children.size() == 1 && point.children[0].x == 3 && point.children[0].label == "leaf");
+  JSONCXX_CHECK(point.children.size() == 1 && point.children[0].children.size() == 1 &&
+                point.children[0].children[0].label == "e\"scaped");
+}
+
+//! Vectors of every kind of element, including std::vector<bool> which has no references to its elements.
+static void testVectors() {
+  Flags flags;
+  bind("{\"bits\": [true, false, null, true], \"grid\": [[1, 2], [], [3]], \"names\": [\"a\", \"\"],"
+       " \"values\": [1, \"two\", [3], {\"four\": 4}, null]}", flags);
+
+  JSONCXX_CHECK(flags.bits.size() == 4);
+  JSONCXX_CHECK(flags.bits.size() == 4 && flags.bits[0] && !flags.bits[1] && !flags.bits[2] && flags.bits[3]);
+  JSONCXX_CHECK(flags.grid.size() == 3 && flags.grid[0].size() == 2 && flags.grid[1].empty() && flags.grid[2][0] == 3);
+  JSONCXX_CHECK(flags.names.size() == 2 && flags.names[0] == "a" && flags.names[1].empty());
+  JSONCXX_CHECK(flags.values.size() == 5 && flags.values[3][std::string("four")].asNatural() == 4);
+  JSONCXX_CHECK(flags.values.size() == 5 && flags.values[4].type() == NullType);
+
+  // a vector is replaced, not appended to
+  bind("{\"bits\": [false]}", flags);
+  JSONCXX_CHECK(flags.bits.size() == 1 && !flags.bits[0]);
+
+  std::vector<bool> bits;
+  bind(" [ true ,false ] ", bits);
+  JSONCXX_CHECK(bits.size() == 2 && bits[0] && !bits[1]);
+}
+
+//! Integers are read within the range of the member, and floating-point members accept integers.
+static void testNumbers() {
+  Limits limits = Limits();
+  bind("{\"i8\": -128, \"u8\": 255, \"i64\": -9223372036854775808, \"u64\": 9223372036854775807,"
+       " \"f\": 0.5, \"d\": 3}", limits);
+  JSONCXX_CHECK(limits.i8 == std::numeric_limits<int8_t>::min());
+  JSONCXX_CHECK(limits.u8 == std::numeric_limits<uint8_t>::max());
+  JSONCXX_CHECK(limits.i64 == std::numeric_limits<int64_t>::min());
+  JSONCXX_CHECK(limits.u64 == (uint64_t)std::numeric_limits<int64_t>::max());
+  JSONCXX_CHECK(limits.f == 0.5f && limits.d == 3.0);
+
+  JSONCXX_CHECK_THROWS(bind("{\"i8\": 128}", limits), parsing_error);
+  JSONCXX_CHECK_THROWS(bind("{\"i8\": -129}", limits), parsing_error);
+  JSONCXX_CHECK_THROWS(bind("{\"u8\": -1}", limits), parsing_error);
+  JSONCXX_CHECK_THROWS(bind("{\"u64\": -1}", limits), parsing_error);
+  JSONCXX_CHECK_THROWS(bind("{\"i64\": 1.0}", limits), parsing_error);
+  JSONCXX_CHECK(limits.i8 == std::numeric_limits<int8_t>::min() && limits.u8 == 255);
+}
+
+//! Missing and null members keep their values, and unknown members are skipped whatever they hold.
+static void testMissing() {
+  Point point = { 7, 8, "keep", std::vector<Point>(1) };
+  bind("{\"unknown\": {\"x\": [1, {\"y\": 2}]}, \"y\": null, \"label\": null, \"children\": null, \"more\": \"}\"}", point);
+  JSONCXX_CHECK(point.x == 7 && point.y == 8);
+  JSONCXX_CHECK(point.label == "keep");
+  JSONCXX_CHECK(point.children.size() == 1);
+
+  bind("{}", point);
+  JSONCXX_CHECK(point.x == 7 && point.label == "keep");
+
+  // names are matched whole
+  bind("{\"xx\": 1, \"labe\": \"no\", \"X\": 2}", point);
+  JSONCXX_CHECK(point.x == 7 && point.label == "keep");
+}
+
+//! Values of another type are errors, after which a reader can be used again.
+static void testMismatches() {
+  Point point = Point();
+  JSONCXX_CHECK_THROWS(bind("{\"x\": \"1\"}", point), parsing_error);
+  JSONCXX_CHECK_THROWS(bind("{\"label\": 1}", point), parsing_error);
+  JSONCXX_CHECK_THROWS(bind("{\"children\": {}}", point), parsing_error);
+  JSONCXX_CHECK_THROWS(bind("{\"children\": [1]}", point), parsing_error);
+  JSONCXX_CHECK_THROWS(bind("[1]", point), parsing_error);
+  JSONCXX_CHECK_THROWS(bind("{\"x\": 1", point), parsing_error);
+  JSONCXX_CHECK_THROWS(bind("{\"x\" 1}", point), parsing_error);
+
+  std::vector<bool> bits;
+  JSONCXX_CHECK_THROWS(bind("[true, 1]", bits), parsing_error);
+  JSONCXX_CHECK_THROWS(bind("[true", bits), parsing_error);
+
+  BindReader<Stream> reader;
+  Stream bad("{\"x\": true}");
+  JSONCXX_CHECK_THROWS(reader.parse(bad, point), parsing_error);
+  Stream good("{\"x\": 9, \"ok\": false}");
+  reader.parse(good, point);
+  JSONCXX_CHECK(point.x == 9);
+}
+
+int main() {
+  testNested();
+  testVectors();
+  testNumbers();
+  testMissing();
+  testMismatches();
+  return report("binding");
+}
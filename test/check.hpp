@@ -0,0 +1,56 @@
+/**
+ *  @file   check.hpp
+ *  @brief    Provide minimal checks shared by the test drivers.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ *
+ *  Each driver is a standalone program, built from this directory with e.g.
+ *  @code
+ *  g++ -std=c++11 -I.. lazy.cpp -o lazy -pthread && ./lazy
+ *  @endcode
+ *  and exits with a non-zero status if a check fails.
+ */
+
+#ifndef _JSONCXX_TEST_CHECK_H_
+#define _JSONCXX_TEST_CHECK_H_
+
+#include <cstdio>
+
+//! Number of failed checks.
+inline int& failures() {
+  static int count = 0;
+  return count;
+}
+
+//! Check a condition, reporting it with its location on failure.
+#define JSONCXX_CHECK(x) \
+  do { \
+    if (!(x)) { \
+      std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #x); \
+      ++failures(); \
+    } \
+  } while (0)
+
+//! Check that a statement throws an exception of the given type.
+#define JSONCXX_CHECK_THROWS(statement, exception) \
+  do { \
+    bool thrown = false; \
+    try { statement; } catch (exception&) { thrown = true; } \
+    if (!thrown) { \
+      std::printf("%s:%d: no %s thrown: %s\n", __FILE__, __LINE__, #exception, #statement); \
+      ++failures(); \
+    } \
+  } while (0)
+
+//! Report the result of a driver and get its exit status.
+inline int report(const char* name) {
+  if (failures() == 0)
+    std::printf("%s: passed\n", name);
+  else
+    std::printf("%s: %d check(s) failed\n", name, failures());
+  return failures() == 0 ? 0 : 1;
+}
+
+#endif // _JSONCXX_TEST_CHECK_H_
@@ -0,0 +1,122 @@
+/**
+ *  @file   depth.cpp
+ *  @brief    Test driver of the nesting limit of Reader and of destroying deep values.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#include "jsoncxx.hpp"
+#include "check.hpp"
+
+#include <string>
+
+using namespace jsoncxx;
+
+//! Arrays nested depth times around a number.
+static std::string nestedArrays(size_t depth) {
+  return std::string(depth, '[') + "1" + std::string(depth, ']');
+}
+
+//! Objects nested depth times around a number.
+static std::string nestedObjects(size_t depth) {
+  std::string json;
+  for (size_t i = 0; i < depth; ++i)
+    json += "{\"a\": ";
+  return json + "1" + std::string(depth, '}');
+}
+
+template <unsigned parseFlags>
+static ParseErrorCode tryParse(reader& r, const std::string& json) {
+  stringstream s(json.c_str());
+  BaseHandler<> handler;
+  return r.tryParse<parseFlags>(s, handler).code;
+}
+
+//! The limit applies to recursive and iterative parsing alike, and to every entry point.
+static void testLimit() {
+  reader r;
+  JSONCXX_CHECK(r.maxDepth() == JSONCXX_MAX_DEPTH);
+
+  const std::string ok = nestedArrays(JSONCXX_MAX_DEPTH), deep = nestedArrays(JSONCXX_MAX_DEPTH + 1);
+  JSONCXX_CHECK(tryParse<ParseDefaultFlags>(r, ok) == ParseErrorNone);
+  JSONCXX_CHECK(tryParse<ParseIterativeFlag>(r, ok) == ParseErrorNone);
+  JSONCXX_CHECK(tryParse<ParseDefaultFlags>(r, deep) == ParseErrorValueTooDeep);
+  JSONCXX_CHECK(tryParse<ParseIterativeFlag>(r, deep) == ParseErrorValueTooDeep);
+
+  const std::string objects = nestedObjects(JSONCXX_MAX_DEPTH + 1);
+  JSONCXX_CHECK(tryParse<ParseDefaultFlags>(r, objects) == ParseErrorValueTooDeep);
+  JSONCXX_CHECK(tryParse<ParseIterativeFlag>(r, objects) == ParseErrorValueTooDeep);
+
+  stringstream s(deep.c_str());
+  JSONCXX_CHECK_THROWS(r.parse(s), parsing_error);
+  value root;
+  stringstream t(deep.c_str());
+  JSONCXX_CHECK(r.tryParse(t, root).code == ParseErrorValueTooDeep);
+
+  // The depth of a failed parse does not carry over to the next one.
+  reader small(3);
+  JSONCXX_CHECK(tryParse<ParseDefaultFlags>(small, "[[[1, [2]]]]") == ParseErrorValueTooDeep);
+  JSONCXX_CHECK(tryParse<ParseDefaultFlags>(small, "[[[1, 2]], [[3]], {\"a\": []}]") == ParseErrorNone);
+  JSONCXX_CHECK(tryParse<ParseDefaultFlags>(small, "[[[1, 2]], [[[3]]]]") == ParseErrorValueTooDeep);
+  JSONCXX_CHECK(tryParse<ParseDefaultFlags>(small, "[[[]]]") == ParseErrorNone);
+
+  Projection<> projection({ "/a/b" });
+  stringstream p("{\"a\": {\"b\": [[1]]}}");
+  JSONCXX_CHECK_THROWS(small.project(p, projection), parsing_error);
+  stringstream q("{\"a\": {\"b\": [1]}}");
+  JSONCXX_CHECK(small.project(q, projection)[std::string("a")][std::string("b")].size() == 1);
+}
+
+//! Adversarial nesting is rejected without exhausting the stack.
+static void testAdversarial() {
+  reader r;
+  const std::string opened(1000000, '[');
+  JSONCXX_CHECK(tryParse<ParseDefaultFlags>(r, opened) == ParseErrorValueTooDeep);
+  JSONCXX_CHECK(tryParse<ParseIterativeFlag>(r, opened) == ParseErrorValueTooDeep);
+
+  stringstream s(opened.c_str());
+  JSONCXX_CHECK(r.validate(s).code == ParseErrorValueTooDeep);
+}
+
+//! Values nested far beyond the default limit are parsed iteratively and destroyed without recursion.
+static void testDestroyDeep() {
+  const size_t depth = 1000000;
+  reader r(depth + 1);
+
+  {
+    std::string json = nestedArrays(depth);
+    stringstream s(json.c_str());
+    value root = r.parse<ParseIterativeFlag>(s);
+    JSONCXX_CHECK(root.type() == ArrayType && root.size() == 1);
+  }
+
+  {
+    std::string json = nestedObjects(depth);
+    stringstream s(json.c_str());
+    value root = r.parse<ParseIterativeFlag>(s);
+    JSONCXX_CHECK(root.type() == ObjectType && root.size() == 1);
+    root.clear();
+    JSONCXX_CHECK(root.type() == NullType);
+  }
+
+  // a wide tree destroys each container once
+  std::string json = "[";
+  for (int i = 0; i < 1000; ++i)
+    json += (i ? ", " : "") + nestedArrays(i % 5) + ", {\"x\": [\"a string long enough to be allocated\"]}";
+  json += "]";
+  stringstream s(json.c_str());
+  value wide = r.parse(s);
+  JSONCXX_CHECK(wide.size() == 2000);
+  value copy = wide;
+  wide = value();
+  JSONCXX_CHECK(copy.size() == 2000 && copy[size_t(1)][std::string("x")].size() == 1);
+}
+
+int main() {
+  testLimit();
+  testAdversarial();
+  testDestroyDeep();
+  return report("depth");
+}
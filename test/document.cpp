@@ -0,0 +1,131 @@
+/**
+ *  @file   document.cpp
+ *  @brief    Test driver of Document and Arena.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#include "jsoncxx.hpp"
+#include "check.hpp"
+
+#include <string>
+
+using namespace jsoncxx;
+
+typedef std::string key;
+
+//! Document of count objects, each with a string too long to be stored in place.
+static std::string records(size_t count) {
+  std::string json = "[";
+  for (size_t i = 0; i < count; ++i)
+    json += std::string(i ? ", " : "") + "{\"id\": " + std::to_string(i) + ", \"text\": \"record text long enough to allocate\"}";
+  return json + "]";
+}
+
+//! The chunks of the arena are kept by clear() and reused by the next parse, which replaces the root.
+static void testReuse() {
+  const std::string large = records(1000), small = records(10);
+  document doc(256);
+  JSONCXX_CHECK(doc.root().type() == NullType);
+
+  stringstream first(large.c_str());
+  doc.parse(first);
+  JSONCXX_CHECK(doc.root().size() == 1000);
+  const size_t capacity = doc.arena().capacity();
+  JSONCXX_CHECK(capacity > 256);
+
+  doc.clear();
+  JSONCXX_CHECK(doc.root().type() == NullType && doc.arena().capacity() == capacity);
+
+  for (int i = 0; i < 10; ++i) {
+    stringstream again(i % 2 ? small.c_str() : large.c_str());
+    doc.parse(again);
+    JSONCXX_CHECK(doc.root().size() == (i % 2 ? 10u : 1000u));
+    JSONCXX_CHECK(doc.root()[size_t(9)][key("text")].asString() == "record text long enough to allocate");
+  }
+  JSONCXX_CHECK(doc.arena().capacity() == capacity);
+
+  // a failed parse leaves a null root and keeps the chunks too
+  stringstream broken("[1, 2");
+  JSONCXX_CHECK_THROWS(doc.parse(broken), parsing_error);
+  JSONCXX_CHECK(doc.root().type() == NullType && doc.arena().capacity() == capacity);
+
+  doc.arena().release();
+  JSONCXX_CHECK(doc.arena().capacity() == 0);
+  doc.clear();
+  JSONCXX_CHECK(doc.root().type() == NullType);
+}
+
+//! A copy of a value of the tree is allocated from the heap, so it outlives the document and its reuse.
+static void testCopyOut() {
+  value copy;
+  value text;
+  {
+    document doc;
+    const std::string json = records(3);
+    stringstream s(json.c_str());
+    doc.parse(s);
+
+    copy = doc.root()[size_t(2)];
+    text = doc.root()[size_t(1)][key("text")];
+    JSONCXX_CHECK(text.asString().c_str() != doc.root()[size_t(1)][key("text")].asString().c_str());
+
+    // reparsing overwrites the arena, but not the copies
+    stringstream other("[\"another document which takes the same memory\", {\"id\": 9}]");
+    doc.parse(other);
+    JSONCXX_CHECK(doc.root().size() == 2);
+  }
+  JSONCXX_CHECK(copy[key("id")].asNatural() == 2);
+  JSONCXX_CHECK(copy[key("text")].asString() == "record text long enough to allocate");
+  JSONCXX_CHECK(text.asString() == "record text long enough to allocate");
+
+  // copies of copies, and values built from them, are ordinary values
+  value list(ArrayType);
+  list.append(copy);
+  list.append(text);
+  copy = value();
+  JSONCXX_CHECK(list[size_t(0)][key("id")].asNatural() == 2 && list[size_t(1)].asString() == text.asString());
+}
+
+//! Values created with the arena are added to the tree and dropped with it.
+static void testInsert() {
+  document doc;
+  stringstream s("{\"name\": \"doc\"}");
+  doc.parse(s);
+
+  value list(ArrayType, &doc.arena());
+  for (int i = 0; i < 100; ++i) {
+    const std::string str = "element " + std::to_string(i) + " of a list built in the arena";
+    list.append(value(str.c_str(), (size_type)str.size(), &doc.arena()));
+  }
+  list.append(value(7));
+  doc.root()[key("list")] = std::move(list);
+
+  value object(ObjectType, &doc.arena());
+  object[key("a member name which is too long to store in place")] = value(true);
+  doc.root()[key("object")] = std::move(object);
+
+  JSONCXX_CHECK(doc.root().size() == 3);
+  JSONCXX_CHECK(doc.root()[key("list")].size() == 101);
+  JSONCXX_CHECK(doc.root()[key("list")][size_t(99)].asString() == "element 99 of a list built in the arena");
+  JSONCXX_CHECK(doc.root()[key("list")][size_t(100)].asNatural() == 7);
+  JSONCXX_CHECK(doc.root()[key("object")][key("a member name which is too long to store in place")].type() == TrueType);
+
+  // members added to a parsed object are named in the arena as well
+  doc.root()[key("a name of a member added after parsing")] = value(1);
+  JSONCXX_CHECK(doc.root().size() == 4);
+
+  // the next parse drops all of them at once
+  stringstream next("[]");
+  doc.parse(next);
+  JSONCXX_CHECK(doc.root().type() == ArrayType && doc.root().size() == 0);
+}
+
+int main() {
+  testReuse();
+  testCopyOut();
+  testInsert();
+  return report("document");
+}
@@ -0,0 +1,151 @@
+/**
+ *  @file   escape.cpp
+ *  @brief    Test driver of decoding escape sequences in strings.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#include "jsoncxx.hpp"
+#include "check.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace jsoncxx;
+
+//! Stream whose characters are read one at a time, since it is not known to be contiguous.
+struct CharStream : public StringStream<UTF8<> > {
+  explicit CharStream(const char* src) : StringStream<UTF8<> >(src) {}
+};
+
+//! Handler which keeps the last string and its length.
+struct StringHandler : public BaseHandler<> {
+  void string(const char* str, size_type length, bool) { str_.assign(str, length); address_ = str; }
+  void key(const char* str, size_type length, bool copy) { string(str, length, copy); }
+
+  std::string str_;
+  const char* address_;
+};
+
+//! Parse a document by copying strings, reading one character at a time and decoding in place.
+/*! @return The error if all of them agree on it, or ParseErrorValueInvalid if they do not.
+ */
+static ParseResult decode(const std::string& json, std::string& str) {
+  StringHandler copied, read, insitu;
+
+  stringstream s(json.c_str());
+  ParseResult result = reader().tryParse(s, copied);
+
+  CharStream c(json.c_str());
+  ParseResult other = Reader<CharStream>().tryParse(c, read);
+
+  std::vector<char> buffer(json.begin(), json.end());
+  buffer.push_back('\0');
+  insitustringstream t(&buffer[0]);
+  ParseResult third = Reader<insitustringstream>().tryParse<ParseInsituFlag>(t, insitu);
+
+  if (result.code != other.code || result.offset != other.offset ||
+      result.code != third.code || result.offset != third.offset)
+    return ParseResult(ParseErrorValueInvalid, 0);
+  if (result && (copied.str_ != read.str_ || copied.str_ != insitu.str_ ||
+                 insitu.address_ < &buffer[0] || insitu.address_ >= &buffer[0] + buffer.size()))
+    return ParseResult(ParseErrorValueInvalid, 0);
+
+  str = copied.str_;
+  return result;
+}
+
+static bool decodes(const std::string& json, const std::string& expected) {
+  std::string str;
+  return decode(json, str) && str == expected;
+}
+
+//! Each single-character escape, alone and among other characters.
+static void testEscapes() {
+  JSONCXX_CHECK(decodes("\"\\\"\\\\\\/\\b\\f\\n\\r\\t\"", "\"\\/\b\f\n\r\t"));
+  JSONCXX_CHECK(decodes("\"\\n\"", "\n"));
+  JSONCXX_CHECK(decodes("\"a\\tb\"", "a\tb"));
+  JSONCXX_CHECK(decodes("\"\\\\\\\\\"", "\\\\"));
+  JSONCXX_CHECK(decodes("\"\\\"quoted\\\"\"", "\"quoted\""));
+
+  // long runs before, between and after escapes
+  const std::string run(100, 'x');
+  JSONCXX_CHECK(decodes("\"" + run + "\\n" + run + "\\u00e9" + run + "\"", run + "\n" + run + "\xC3\xA9" + run));
+}
+
+//! \u escapes of one unit, in either case of hexadecimal digits, and surrogate pairs of four bytes in UTF-8.
+static void testUnicode() {
+  JSONCXX_CHECK(decodes("\"\\u0041\\u00e9\\u00E9\\u20ac\\uFFFF\"", "A\xC3\xA9\xC3\xA9\xE2\x82\xAC\xEF\xBF\xBF"));
+  JSONCXX_CHECK(decodes("\"\\u007f\\u0080\\u07ff\\u0800\"", "\x7F\xC2\x80\xDF\xBF\xE0\xA0\x80"));
+  JSONCXX_CHECK(decodes("\"a\\u0000b\"", std::string("a\0b", 3)));
+
+  JSONCXX_CHECK(decodes("\"\\ud83d\\ude00\"", "\xF0\x9F\x98\x80"));
+  JSONCXX_CHECK(decodes("\"\\uD800\\uDC00\"", "\xF0\x90\x80\x80"));
+  JSONCXX_CHECK(decodes("\"\\uDBFF\\uDFFF\"", "\xF4\x8F\xBF\xBF"));
+  JSONCXX_CHECK(decodes("\"x\\uD83D\\uDE00\\uD83D\\uDE01y\"", "x\xF0\x9F\x98\x80\xF0\x9F\x98\x81y"));
+
+  // names of members are decoded alike
+  JSONCXX_CHECK(decodes("{\"\\ud83d\\ude00\\n\": 1}", "\xF0\x9F\x98\x80\n"));
+}
+
+//! Lone surrogates, bad digits and unknown escapes are errors at the escape, wherever they are decoded.
+static void testErrors() {
+  struct Case {
+    const char*     json;
+    ParseErrorCode  code;
+    size_t          offset;
+  } cases[] = {
+    { "\"\\uD800\"",          ParseErrorStringUnicodeSurrogateInvalid,  2 },
+    { "\"\\uDBFF\"",          ParseErrorStringUnicodeSurrogateInvalid,  2 },
+    { "\"ab\\uD800x\"",       ParseErrorStringUnicodeSurrogateInvalid,  4 },
+    { "\"\\uD800\\n\"",       ParseErrorStringUnicodeSurrogateInvalid,  2 },
+    { "\"\\uD800\\u0041\"",   ParseErrorStringUnicodeSurrogateInvalid,  2 },
+    { "\"\\uD800\\uD800\"",   ParseErrorStringUnicodeSurrogateInvalid,  2 },
+    { "\"\\uDC00\"",          ParseErrorStringUnicodeSurrogateInvalid,  2 },
+    { "\"\\uDFFF\\uDC00\"",   ParseErrorStringUnicodeSurrogateInvalid,  2 },
+    { "\"\\uD800\\uDC0G\"",   ParseErrorStringUnicodeEscapeInvalidHex,  12 },
+    { "\"\\u12G4\"",          ParseErrorStringUnicodeEscapeInvalidHex,  5 },
+    { "\"\\u123\"",           ParseErrorStringUnicodeEscapeInvalidHex,  6 },
+    { "\"\\u12",              ParseErrorStringUnicodeEscapeInvalidHex,  5 },
+    { "\"\\x41\"",            ParseErrorStringEscapeInvalid,            2 },
+    { "\"\\U0041\"",          ParseErrorStringEscapeInvalid,            2 },
+    { "\"\\'\"",              ParseErrorStringEscapeInvalid,            2 },
+  };
+
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+    std::string str;
+    ParseResult result = decode(cases[i].json, str);
+    JSONCXX_CHECK(result.code == cases[i].code);
+    JSONCXX_CHECK(result.offset == cases[i].offset);
+  }
+}
+
+//! In-situ decoding writes over the escapes, and leaves the rest of the document intact.
+static void testInsitu() {
+  std::string json = "[\"\\u00e9t\\u00e9\", \"\\ud83d\\ude00\", {\"\\t\": \"\\\\n\"}, \"plain\", \"" +
+                     std::string(50, 'y') + "\\\"" + std::string(50, 'z') + "\"]";
+  std::vector<char> buffer(json.begin(), json.end());
+  buffer.push_back('\0');
+  insitustringstream s(&buffer[0]);
+  value root = Reader<insitustringstream>().parse<ParseInsituFlag>(s);
+
+  JSONCXX_CHECK(root.size() == 5);
+  JSONCXX_CHECK(root[size_t(0)].asString() == "\xC3\xA9t\xC3\xA9");
+  JSONCXX_CHECK(root[size_t(1)].asString() == "\xF0\x9F\x98\x80");
+  JSONCXX_CHECK(root[size_t(2)][std::string("\t")].asString() == "\\n");
+  JSONCXX_CHECK(root[size_t(3)].asString() == "plain");
+  JSONCXX_CHECK(root[size_t(4)].asString() == std::string(50, 'y') + "\"" + std::string(50, 'z'));
+
+  const char* str = root[size_t(4)].asString().c_str();
+  JSONCXX_CHECK(str >= &buffer[0] && str < &buffer[0] + buffer.size() && str[101] == '\0');
+}
+
+int main() {
+  testEscapes();
+  testUnicode();
+  testErrors();
+  testInsitu();
+  return report("escape");
+}
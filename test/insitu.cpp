@@ -0,0 +1,103 @@
+/**
+ *  @file   insitu.cpp
+ *  @brief    Test driver of in-situ parsing and of strings referring to external characters.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#include "jsoncxx.hpp"
+#include "check.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace jsoncxx;
+
+typedef Reader<insitustringstream> insitureader;
+
+static std::vector<char> terminated(const std::string& json) {
+  std::vector<char> buffer(json.begin(), json.end());
+  buffer.push_back('\0');
+  return buffer;
+}
+
+static bool inside(const std::vector<char>& buffer, const char* p) {
+  return p >= &buffer[0] && p < &buffer[0] + buffer.size();
+}
+
+//! Strings are decoded and terminated in the buffer, and values refer to them.
+static void testInPlace() {
+  std::vector<char> buffer = terminated(
+    "{\"plain\": \"a string without escapes\", \"escaped\": \"tab\\there \\\"quoted\\\" \\u00e9\\ud83d\\ude00\","
+    " \"list\": [\"x\", \"\\\\\"]}");
+  insitustringstream s(&buffer[0]);
+  value root = insitureader().parse<ParseInsituFlag>(s);
+
+  value::string_ref plain = root[std::string("plain")].asString();
+  JSONCXX_CHECK(plain == "a string without escapes" && inside(buffer, plain.c_str()));
+  JSONCXX_CHECK(plain.c_str()[plain.length()] == '\0');
+
+  value::string_ref escaped = root[std::string("escaped")].asString();
+  JSONCXX_CHECK(escaped == "tab\there \"quoted\" \xC3\xA9\xF0\x9F\x98\x80" && inside(buffer, escaped.c_str()));
+  JSONCXX_CHECK(escaped.c_str()[escaped.length()] == '\0');
+
+  JSONCXX_CHECK(root[std::string("list")][size_t(0)].asString() == "x");
+  JSONCXX_CHECK(root[std::string("list")][size_t(1)].asString() == "\\");
+
+  // copies refer to the same buffer, and str() keeps the characters beyond it
+  value copy = root;
+  JSONCXX_CHECK(copy[std::string("plain")].asString().c_str() == plain.c_str());
+  std::string kept = plain.str();
+  std::fill(buffer.begin(), buffer.end(), '#');
+  JSONCXX_CHECK(kept == "a string without escapes");
+}
+
+//! Errors of in-situ parsing are reported like those of other parsing.
+static void testErrors() {
+  const char* broken[] = { "[\"open", "[\"bad \\x escape\"]", "[\"\\ud800\"]", "{\"a\" \"b\"}" };
+  for (size_t i = 0; i < sizeof(broken) / sizeof(broken[0]); ++i) {
+    std::vector<char> buffer = terminated(broken[i]);
+    insitustringstream s(&buffer[0]);
+    JSONCXX_CHECK_THROWS(insitureader().parse<ParseInsituFlag>(s), parsing_error);
+  }
+}
+
+//! Strings are read through string_ref, converted to std::string, and replaced by assignment.
+static void testStringAccess() {
+  value v("before");
+  std::string str = v;
+  JSONCXX_CHECK(str == "before");
+  JSONCXX_CHECK(v.asString().str() == "before");
+
+  v = value(v.asString().str() + " and after");
+  JSONCXX_CHECK(v.asString() == "before and after");
+  v = std::string("replaced");
+  JSONCXX_CHECK(v.asString() == "replaced");
+
+  const char external[] = "external characters";
+  value ref((value::string_ref(external)));
+  JSONCXX_CHECK(ref.asString().c_str() == external);
+}
+
+//! Strings holding null characters are written whole.
+static void testNullCharacters() {
+  stringstream s("[\"a\\u0000b\"]");
+  value root = reader().parse(s);
+  JSONCXX_CHECK(root[size_t(0)].asString().length() == 3);
+
+  std::ostringstream out;
+  out << root;
+  JSONCXX_CHECK(out.str() == std::string("[\"a\0b\"]", 7));
+}
+
+int main() {
+  testInPlace();
+  testErrors();
+  testStringAccess();
+  testNullCharacters();
+  return report("insitu");
+}
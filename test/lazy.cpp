@@ -0,0 +1,130 @@
+/**
+ *  @file   lazy.cpp
+ *  @brief    Test driver of LazyDocument and LazyValue.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#include "jsoncxx.hpp"
+#include "check.hpp"
+
+#include <sstream>
+#include <string>
+
+using namespace jsoncxx;
+
+static std::string print(const value& v) {
+  std::ostringstream os;
+  os << v;
+  return os.str();
+}
+
+//! Brackets, commas, colons and escaped quotation marks in strings are not taken for structure, at any offset in a block.
+static void testStringsInBlocks() {
+  bool same = true;
+  for (size_t pad = 0; pad < 70; ++pad) {
+    const std::string json = "{\"pad\": \"" + std::string(pad, ' ') + "\", \"tricky\": \"}],:{[\\\"\\\\\","
+                             " \"e\\\"scaped\": [\"\\\\\", {\"x\": \"]\"}], \"last\": " + std::to_string(pad) + "}";
+    LazyDocument<> doc(json.c_str(), json.size());
+    LazyValue<> root = doc.root();
+    same = same && root.size() == 4;
+    same = same && root["tricky"].asString() == "}],:{[\"\\";
+    same = same && root["e\"scaped"][1]["x"].asString() == "]";
+    same = same && root["last"].asNatural() == (natural)pad;
+  }
+  JSONCXX_CHECK(same);
+}
+
+//! Values before the one looked up are jumped over without decoding, however deep they are.
+static void testSkipping() {
+  std::string json = "[";
+  for (int i = 0; i < 1000; ++i)
+    json += (i ? ", " : "") + std::string(i % 10, '[') + std::to_string(i) + std::string(i % 10, ']');
+  json += "]";
+  LazyDocument<> doc(json.c_str());
+  LazyValue<> root = doc.root();
+  JSONCXX_CHECK(root.size() == 1000);
+
+  LazyValue<> element = root[999];
+  for (int i = 0; i < 9; ++i)
+    element = element[0];
+  JSONCXX_CHECK(element.asNatural() == 999);
+
+  // names are matched whole, and decoded only when they have escapes
+  LazyDocument<> names("{\"ab\": 1, \"a\": 2, \"\\u0061\\u0062c\": 3, \"abcd\": 4}");
+  JSONCXX_CHECK(names.root()["a"].asNatural() == 2);
+  JSONCXX_CHECK(names.root()["abc"].asNatural() == 3);
+  JSONCXX_CHECK(names.root()["abcd"].asNatural() == 4);
+  JSONCXX_CHECK(!names.root()["abcde"].exists());
+
+  std::string keys;
+  for (LazyValue<>::const_iterator itr = names.root().begin(); itr != names.root().end(); ++itr)
+    keys += itr.key() + ",";
+  JSONCXX_CHECK(keys == "ab,a,abc,abcd,");
+}
+
+//! Decoding a lazy value gives what parsing it with Reader gives, for scalars at the root and empty containers.
+static void testDecoding() {
+  const char* documents[] = {
+    "42", "  -1.5e3 ", "\"text\"", "true", "false", "null", "[]", "{}", " [ [ ] , { } ] ",
+    "{\"user\": {\"name\": \"seonho\", \"tags\": [\"a\", \"b\"]}, \"ratio\": 0.5, \"none\": null}",
+  };
+  for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); ++i) {
+    LazyDocument<> doc(documents[i]);
+    stringstream s(documents[i]);
+    JSONCXX_CHECK(print(doc.root().get()) == print(reader().parse(s)));
+  }
+
+  LazyDocument<> doc("{\"s\": \"\\u00e9\\n\", \"plain\": \"abc\", \"n\": 3, \"r\": 0.5, \"b\": true}");
+  JSONCXX_CHECK(doc.root()["s"].asString() == "\xC3\xA9\n");
+  JSONCXX_CHECK(doc.root()["plain"].asString() == "abc");
+  JSONCXX_CHECK(doc.root()["n"].asNatural() == 3 && doc.root()["r"].asReal() == 0.5 && doc.root()["b"].asBool());
+
+  LazyDocument<> empty("[[], {}]");
+  JSONCXX_CHECK(empty.root()[0].size() == 0 && empty.root()[0].begin() == empty.root()[0].end());
+  JSONCXX_CHECK(empty.root()[1].size() == 0 && !empty.root()[1]["a"].exists());
+}
+
+//! Lookups of missing values and through values of another type give a missing value, which can be chained.
+static void testMissing() {
+  LazyDocument<> doc("{\"count\": 3, \"tags\": [\"a\", \"b\"], \"user\": {\"name\": \"x\"}, \"none\": null}");
+  LazyValue<> root = doc.root();
+
+  LazyValue<> missing = root["nobody"]["name"];
+  JSONCXX_CHECK(!missing.exists() && missing.type() == NullType);
+  JSONCXX_CHECK(missing.size() == 0 && missing.begin() == missing.end());
+  JSONCXX_CHECK(!missing[0]["x"].exists() && missing.get().type() == NullType);
+
+  JSONCXX_CHECK(root["none"].exists() && root["none"].type() == NullType);
+  JSONCXX_CHECK(!root["tags"][2].exists());
+  JSONCXX_CHECK(!root["count"]["x"].exists() && root["count"].size() == 0);
+  JSONCXX_CHECK(!root["user"][0].exists());
+  JSONCXX_CHECK(!root["tags"]["a"].exists());
+}
+
+//! Only the parts which are reached are checked, so errors are reported when they are reached.
+static void testPartialErrors() {
+  LazyDocument<> doc("{\"a\": [1, 2}, \"b\": 1}");
+  JSONCXX_CHECK_THROWS(doc.root()["a"].size(), parsing_error);
+  JSONCXX_CHECK(doc.root()["b"].asNatural() == 1);
+
+  LazyDocument<> values("[1, tru, 3]");
+  JSONCXX_CHECK(values.root()[2].asNatural() == 3);
+  JSONCXX_CHECK_THROWS(values.root()[1].get(), parsing_error);
+
+  JSONCXX_CHECK_THROWS(LazyDocument<>("{\"a\": [1, 2").root()["b"], parsing_error);
+  JSONCXX_CHECK_THROWS(LazyDocument<>("{\"a\" 1}").root()["a"], parsing_error);
+  JSONCXX_CHECK_THROWS(LazyDocument<>("{1: 2}").root().begin(), parsing_error);
+  JSONCXX_CHECK_THROWS(LazyDocument<>("[1 2]").root().size(), parsing_error);
+}
+
+int main() {
+  testStringsInBlocks();
+  testSkipping();
+  testDecoding();
+  testMissing();
+  testPartialErrors();
+  return report("lazy");
+}
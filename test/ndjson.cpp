@@ -0,0 +1,146 @@
+/**
+ *  @file   ndjson.cpp
+ *  @brief    Test driver of NdjsonReader.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#include "jsoncxx.hpp"
+#include "check.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace jsoncxx;
+
+typedef NdjsonReader<>::Record Record;
+
+static std::vector<Record> parse(const std::string& input, size_t threads = 4, size_t chunkSize = 8) {
+  ThreadPool pool(threads);
+  return NdjsonReader<>(pool, chunkSize).parse(input.c_str(), input.size());
+}
+
+//! Reading a memory-mapped file, as documented.
+static void testMappedFile() {
+  const char* filename = "ndjson_test.ndjson";
+  std::FILE* f = std::fopen(filename, "wb");
+  JSONCXX_CHECK(f != 0);
+  if (!f)
+    return;
+  std::fputs("{\"id\": 1}\n{\"id\": 2}\n", f);
+  std::fclose(f);
+
+  {
+    MemoryMappedFile<UTF8<> > file(filename);
+    JSONCXX_CHECK(file.isOpen());
+    NdjsonReader<> reader;
+    std::vector<Record> records = reader.parse(file.data(), file.size());
+    JSONCXX_CHECK(records.size() == 2);
+    JSONCXX_CHECK(records.size() == 2 && records[1].ok() && records[1].value[std::string("id")].asNatural() == 2);
+  }
+  std::remove(filename);
+}
+
+//! Blank lines are skipped but counted, and white spaces and carriage returns around values are ignored.
+static void testLineNumbers() {
+  std::vector<Record> records = parse("\n  \r\n\t[1, 2]  \r\n\n\"text\"\nnull");
+  JSONCXX_CHECK(records.size() == 3);
+  if (records.size() != 3)
+    return;
+  JSONCXX_CHECK(records[0].line == 3 && records[0].ok() && records[0].value.size() == 2);
+  JSONCXX_CHECK(records[1].line == 5 && records[1].ok() && records[1].value.asString() == "text");
+  JSONCXX_CHECK(records[2].line == 6 && records[2].ok() && records[2].value.type() == NullType);
+
+  JSONCXX_CHECK(parse("").empty());
+  JSONCXX_CHECK(parse("\n \n\r\n").empty());
+}
+
+//! A broken line is reported alone: it never reads into the next lines, which are still parsed.
+static void testBrokenLines() {
+  std::string input =
+    "{\"a\": \n"        // 1: incomplete
+    "1}\n"              // 2: not a value
+    "[1,\n"             // 3: continues on the next line
+    "2]\n"              // 4
+    "1 2\n"             // 5: two values
+    "\"open\n"          // 6: string not closed on its line
+    "\"closed\"\n";     // 7
+  input += std::string("[\0]", 3) + "\n";  // 8: null character in the line
+  input += "true";                         // 9
+
+  std::vector<Record> records = parse(input);
+  JSONCXX_CHECK(records.size() == 9);
+  if (records.size() != 9)
+    return;
+
+  for (size_t i = 0; i < 9; ++i) {
+    JSONCXX_CHECK(records[i].line == i + 1);
+    JSONCXX_CHECK(records[i].ok() == (i == 6 || i == 8));
+    if (!records[i].ok())
+      JSONCXX_CHECK(records[i].value.type() == NullType);
+  }
+  JSONCXX_CHECK(records[4].error == GetParseErrorMessage(ParseErrorDocumentRootNotSingular));
+  JSONCXX_CHECK(records[5].error == GetParseErrorMessage(ParseErrorStringMissQuotationMark));
+  JSONCXX_CHECK(records[6].value.asString() == "closed");
+}
+
+//! Lines of unclosed or deeply nested values cost time in proportion to themselves and never crash.
+static void testAdversarialLines() {
+  std::string unclosed;
+  for (int i = 0; i < 200000; ++i)
+    unclosed += "[\n";
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::vector<Record> records = parse(unclosed, 1, 1 << 20);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  JSONCXX_CHECK(records.size() == 200000);
+  JSONCXX_CHECK(records.size() == 200000 && !records.back().ok() && records.back().line == 200000);
+  JSONCXX_CHECK(seconds < 10);
+
+  std::string deep = std::string(JSONCXX_MAX_DEPTH + 1, '[') + std::string(JSONCXX_MAX_DEPTH + 1, ']') + "\n" +
+                     std::string(1000000, '[') + "\n" +
+                     std::string(JSONCXX_MAX_DEPTH, '[') + std::string(JSONCXX_MAX_DEPTH, ']') + "\n";
+  records = parse(deep, 2, 1);
+  JSONCXX_CHECK(records.size() == 3);
+  JSONCXX_CHECK(records.size() == 3 && records[0].error == GetParseErrorMessage(ParseErrorValueTooDeep));
+  JSONCXX_CHECK(records.size() == 3 && records[1].error == GetParseErrorMessage(ParseErrorValueTooDeep));
+  JSONCXX_CHECK(records.size() == 3 && records[2].ok());
+}
+
+//! Many chunks are parsed in parallel, and the callback sees every record once.
+static void testChunks() {
+  std::string input;
+  const size_t count = 1000;
+  for (size_t i = 0; i < count; ++i)
+    input += "{\"i\": " + std::to_string(i) + ", \"s\": \"" + std::string(i % 7, 'x') + "\"}\n";
+
+  std::vector<Record> records = parse(input, 4, 256);
+  JSONCXX_CHECK(records.size() == count);
+  bool ordered = records.size() == count;
+  for (size_t i = 0; ordered && i < count; ++i)
+    ordered = records[i].line == i + 1 && records[i].value[std::string("i")].asNatural() == (natural)i;
+  JSONCXX_CHECK(ordered);
+
+  ThreadPool pool(4);
+  std::atomic<size_t> seen(0), sum(0);
+  NdjsonReader<>(pool, 256).parse(input.c_str(), input.size(), [&](Record& record) {
+    ++seen;
+    sum += (size_t)record.value[std::string("i")].asNatural();
+  });
+  JSONCXX_CHECK(seen == count);
+  JSONCXX_CHECK(sum == count * (count - 1) / 2);
+}
+
+int main() {
+  testMappedFile();
+  testLineNumbers();
+  testBrokenLines();
+  testAdversarialLines();
+  testChunks();
+  return report("ndjson");
+}
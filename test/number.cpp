@@ -0,0 +1,159 @@
+/**
+ *  @file   number.cpp
+ *  @brief    Test driver of parsing numbers, against strtod.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#include "jsoncxx.hpp"
+#include "check.hpp"
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+
+using namespace jsoncxx;
+
+//! Handler which keeps a number and whether it is natural.
+struct NumberHandler : public BaseHandler<> {
+  NumberHandler() : natural_(false), n_(0), r_(0) {}
+
+  void number(natural n)  { natural_ = true; n_ = n; }
+  void number(real r)     { natural_ = false; r_ = r; }
+
+  bool    natural_;
+  natural n_;
+  real    r_;
+};
+
+static ParseResult parse(const std::string& json, NumberHandler& handler) {
+  stringstream s(json.c_str());
+  return reader().tryParse(s, handler);
+}
+
+//! Check whether a number parses to the real which strtod rounds it to, bit for bit.
+static bool same(const std::string& json) {
+  NumberHandler handler;
+  if (!parse(json, handler) || handler.natural_)
+    return false;
+  const real expected = std::strtod(json.c_str(), 0);
+  return std::memcmp(&handler.r_, &expected, sizeof(real)) == 0;
+}
+
+//! Integers up to 19 digits are natural if they fit, and -0 keeps its sign as a real.
+static void testIntegers() {
+  NumberHandler h;
+  JSONCXX_CHECK(parse("0", h) && h.natural_ && h.n_ == 0);
+  JSONCXX_CHECK(parse("-0", h) && !h.natural_ && h.r_ == 0 && std::signbit(h.r_));
+  JSONCXX_CHECK(parse("-0.0", h) && !h.natural_ && std::signbit(h.r_));
+  JSONCXX_CHECK(parse("-0e5", h) && !h.natural_ && std::signbit(h.r_));
+
+  JSONCXX_CHECK(parse("1234567890123456789", h) && h.natural_ && h.n_ == 1234567890123456789LL);
+  JSONCXX_CHECK(parse("9223372036854775807", h) && h.natural_ && h.n_ == std::numeric_limits<natural>::max());
+  JSONCXX_CHECK(parse("-9223372036854775808", h) && h.natural_ && h.n_ == std::numeric_limits<natural>::min());
+  JSONCXX_CHECK(parse("9223372036854775808", h) && !h.natural_ && h.r_ == 9223372036854775808.0);
+  JSONCXX_CHECK(parse("-9223372036854775809", h) && !h.natural_ && h.r_ == -9223372036854775808.0);
+  JSONCXX_CHECK(parse("9999999999999999999", h) && !h.natural_);
+
+  // 20 digits, and integers with a fraction or an exponent, are real
+  const char* reals[] = {
+    "12345678901234567890", "99999999999999999999", "18446744073709551615", "18446744073709551616",
+    "10000000000000000000", "-12345678901234567890", "1.0", "1e0", "100e-2",
+  };
+  for (size_t i = 0; i < sizeof(reals) / sizeof(reals[0]); ++i)
+    JSONCXX_CHECK(same(reals[i]));
+}
+
+//! Significands of 19 and 20 digits across the exact fast path and its limits.
+static void testSignificands() {
+  const char* numbers[] = {
+    "9007199254740992.0", "9007199254740993.0", "9007199254740995e0", "90071992547409930e-1",
+    "1234567890123456789e-5", "1234567890123456789e22", "1234567890123456789e23", "1234567890123456789e-23",
+    "12345678901234567890e-25", "12345678901234567891e3", "0.1234567890123456789", "0.12345678901234567891",
+    "9999999999999999999e-22", "99999999999999999999e22", "0.000000000000000000001234567890123456789",
+    "123456789012345678.9", "1.7976931348623157", "4503599627370497.5", "4503599627370496.5",
+  };
+  for (size_t i = 0; i < sizeof(numbers) / sizeof(numbers[0]); ++i)
+    JSONCXX_CHECK(same(numbers[i]));
+
+  // every double printed with 17 significant digits parses back to itself
+  unsigned long long bits = 0x123456789ABCDEFULL;
+  bool roundTrip = true;
+  for (int i = 0; i < 100000; ++i) {
+    bits = bits * 6364136223846793005ULL + 1442695040888963407ULL;
+    real r;
+    std::memcpy(&r, &bits, sizeof(r));
+    if (!std::isfinite(r))
+      continue;
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.16e", r);
+    NumberHandler handler;
+    roundTrip = roundTrip && parse(buffer, handler) && !handler.natural_ && std::memcmp(&handler.r_, &r, sizeof(r)) == 0;
+  }
+  JSONCXX_CHECK(roundTrip);
+}
+
+//! Exponents around the largest and the smallest doubles, including subnormals and underflow to zero.
+static void testExponents() {
+  const char* numbers[] = {
+    "1e308", "1.7976931348623157e308", "1.7976931348623158e308", "-1.7976931348623157e308", "179.76931348623157e306",
+    "2.2250738585072014e-308", "2.2250738585072011e-308", "2.2250738585072012e-308", "1e-308", "1e-310",
+    "4.9406564584124654e-324", "2.4703282292062327e-324", "2.4703282292062328e-324", "7.4109846876186982e-324",
+    "1e-324", "1e-400", "-1e-400", "0e99999", "1e-99999999999", "0.000001e-318",
+  };
+  for (size_t i = 0; i < sizeof(numbers) / sizeof(numbers[0]); ++i)
+    JSONCXX_CHECK(same(numbers[i]));
+
+  NumberHandler h;
+  JSONCXX_CHECK(parse("4.9406564584124654e-324", h) && h.r_ == std::numeric_limits<real>::denorm_min());
+  JSONCXX_CHECK(parse("2.4703282292062327e-324", h) && h.r_ == 0);
+  JSONCXX_CHECK(parse("-1e-400", h) && h.r_ == 0 && std::signbit(h.r_));
+  JSONCXX_CHECK(parse("1.7976931348623157e308", h) && h.r_ == DBL_MAX);
+
+  const char* huge[] = { "1.7976931348623159e308", "1e309", "-1e309", "1e99999999999", "2e308" };
+  for (size_t i = 0; i < sizeof(huge) / sizeof(huge[0]); ++i)
+    JSONCXX_CHECK(parse(huge[i], h).code == ParseErrorNumberTooBig);
+}
+
+//! Digits beyond JSONCXX_MAX_DIGITS only tell whether the number is above the digits kept, which decides a tie.
+static void testManyDigits() {
+  // 2^53 + 1 is halfway between two doubles, so a nonzero digit far after it rounds up
+  const std::string half = "9007199254740993";
+  const std::string zeros(JSONCXX_MAX_DIGITS + 10, '0');
+
+  NumberHandler h;
+  const std::string scale = "e-" + std::to_string(zeros.size() + 1);
+  JSONCXX_CHECK(same(half + zeros + "0" + scale));
+  JSONCXX_CHECK(same(half + zeros + "1" + scale));
+  JSONCXX_CHECK(same(half + "." + zeros));
+  JSONCXX_CHECK(same(half + "." + zeros + "1"));
+  JSONCXX_CHECK(parse(half + "." + zeros, h) && h.r_ == 9007199254740992.0);
+  JSONCXX_CHECK(parse(half + "." + zeros + "1", h) && h.r_ == 9007199254740994.0);
+  JSONCXX_CHECK(parse(half + zeros + "1" + scale, h) && h.r_ == 9007199254740994.0);
+
+  // leading zeros of a fraction are not significant digits
+  JSONCXX_CHECK(same("0." + zeros + half));
+  JSONCXX_CHECK(same("0." + std::string(300, '0') + half + zeros + "1"));
+
+  // many digits which are all significant
+  std::string digits;
+  for (size_t i = 0; i < 2000; ++i)
+    digits += (char)('1' + i % 9);
+  JSONCXX_CHECK(same(digits + "e-1700"));
+  JSONCXX_CHECK(same("0." + digits));
+  JSONCXX_CHECK(parse(digits, h).code == ParseErrorNumberTooBig);
+}
+
+int main() {
+  testIntegers();
+  testSignificands();
+  testExponents();
+  testManyDigits();
+  return report("number");
+}
@@ -0,0 +1,154 @@
+/**
+ *  @file   parallel.cpp
+ *  @brief    Test driver of ThreadPool and ParallelArrayReader.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#include "jsoncxx.hpp"
+#include "check.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace jsoncxx;
+
+static std::string print(const value& v) {
+  std::ostringstream os;
+  os << v;
+  return os.str();
+}
+
+//! Check whether the reader parses a document to what Reader parses it to.
+static bool sequential(ParallelArrayReader<>& parallel, const std::string& json) {
+  stringstream s(json.c_str());
+  return print(parallel.parse(json.c_str(), json.size())) == print(reader().parse(s));
+}
+
+//! Elements are split at top-level commas only, wherever strings with brackets, commas and escapes fall in the blocks of the index.
+static void testBoundaries() {
+  ThreadPool pool(4);
+  ParallelArrayReader<> parallel(pool, 3);
+
+  bool same = true;
+  for (size_t pad = 0; pad < 70; ++pad) {
+    const std::string json = "[\"" + std::string(pad, ' ') + "\", \"a, b]\", \"\\\"],[\\\\\", [1, [\",\"]], {\"k,]\": {\"x\": [2, 3]}},"
+                             " \"\\\\\", " + std::to_string(pad) + "]";
+    same = same && sequential(parallel, json);
+  }
+  JSONCXX_CHECK(same);
+
+  const char* documents[] = { "[]", " [ ] ", "[[]]", "[{}]", " [ 1 ,\t2 ,\n3 ] ", "[[], {}, [[], []]]", "[\"]\"]" };
+  for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); ++i)
+    JSONCXX_CHECK(sequential(parallel, documents[i]));
+}
+
+//! Elements keep their order however they are grouped into tasks, for fewer, as many and more elements than tasks.
+static void testGrouping() {
+  ThreadPool pool(4), single(1);
+  JSONCXX_CHECK(pool.size() == 4 && single.size() == 1);
+
+  bool same = true;
+  std::string json = "[";
+  for (size_t count = 1; count <= 100; ++count) {
+    json.resize(json.size() - (count > 1 ? 1 : 0));
+    json += (count > 1 ? ", " : "") + std::string(count % 7 == 0 ? "{\"i\": [" : "[") + std::to_string(count) +
+            (count % 7 == 0 ? "]}" : "]") + "]";
+    for (size_t tasksPerThread = 1; tasksPerThread <= 8; tasksPerThread *= 2) {
+      ParallelArrayReader<> parallel(pool, tasksPerThread), serial(single, tasksPerThread);
+      same = same && sequential(parallel, json) && sequential(serial, json);
+    }
+  }
+  JSONCXX_CHECK(same);
+
+  // a root which is not an array is parsed as a whole
+  ParallelArrayReader<> parallel(pool);
+  JSONCXX_CHECK(sequential(parallel, "{\"a\": [1, 2], \"b\": \",\"}"));
+  JSONCXX_CHECK(sequential(parallel, " 42 "));
+  JSONCXX_CHECK(sequential(parallel, "\"[1, 2]\""));
+}
+
+//! A memory-mapped file, which is followed by a null character, is read in place.
+static void testMappedFile() {
+  const char* filename = "parallel_test.json";
+  std::FILE* f = std::fopen(filename, "wb");
+  JSONCXX_CHECK(f != 0);
+  if (!f)
+    return;
+  std::fputs("[{\"id\": 1}, {\"id\": 2}, {\"id\": 3}]\n", f);
+  std::fclose(f);
+
+  {
+    MemoryMappedFile<UTF8<> > file(filename);
+    JSONCXX_CHECK(file.isOpen());
+    value records = ParallelArrayReader<>().parse(file.data(), file.size());
+    JSONCXX_CHECK(records.size() == 3 && records[size_t(2)][std::string("id")].asNatural() == 3);
+  }
+  std::remove(filename);
+}
+
+//! Errors between elements and in any element are thrown, and the reader and its pool can be used again.
+static void testErrors() {
+  ThreadPool pool(4);
+  ParallelArrayReader<> parallel(pool, 2);
+
+  const char* documents[] = {
+    "[1, 2", "[1 2]", "[1, 2] 3", "[1, 2]]", "[1, tru, 3]", "[1, {\"a\" 1}, 3]", "[1, , 3]", "[,]", "[1,]",
+    "[1, [2}, 3]", "[\"unterminated, 2]", "{\"a\": }",
+  };
+  for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); ++i)
+    JSONCXX_CHECK_THROWS(parallel.parse(documents[i], std::strlen(documents[i])), parsing_error);
+
+  // an error in the last of many elements
+  std::string json = "[";
+  for (int i = 0; i < 1000; ++i)
+    json += std::to_string(i) + ", ";
+  JSONCXX_CHECK_THROWS(parallel.parse((json + "nul]").c_str(), json.size() + 4), parsing_error);
+  JSONCXX_CHECK(sequential(parallel, json + "null]"));
+}
+
+//! Every index is run once even if some throw, and a task can run a nested loop on the same pool.
+static void testPool() {
+  ThreadPool pool(4);
+
+  std::vector<std::atomic<int> > runs(1000);
+  JSONCXX_CHECK_THROWS(pool.parallelFor(runs.size(), [&](size_t i) {
+    ++runs[i];
+    if (i % 10 == 3)
+      throw std::runtime_error("task");
+  }), std::runtime_error);
+  bool once = true;
+  for (size_t i = 0; i < runs.size(); ++i)
+    once = once && runs[i] == 1;
+  JSONCXX_CHECK(once);
+
+  std::atomic<size_t> calls(0);
+  pool.parallelFor(0, [&](size_t) { ++calls; });
+  JSONCXX_CHECK(calls == 0);
+
+  pool.parallelFor(8, [&](size_t) {
+    pool.parallelFor(100, [&](size_t) { ++calls; });
+  });
+  JSONCXX_CHECK(calls == 800);
+
+  ThreadPool single(1);
+  calls = 0;
+  single.parallelFor(100, [&](size_t) { ++calls; });
+  JSONCXX_CHECK(calls == 100);
+}
+
+int main() {
+  testBoundaries();
+  testGrouping();
+  testMappedFile();
+  testErrors();
+  testPool();
+  return report("parallel");
+}
@@ -0,0 +1,128 @@
+/**
+ *  @file   projection.cpp
+ *  @brief    Test driver of Projection and Reader::project().
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#include "jsoncxx.hpp"
+#include "check.hpp"
+
+#include <string>
+
+using namespace jsoncxx;
+
+typedef std::string key;
+
+static const char* json =
+  "{\"user\": {\"name\": \"seonho\", \"id\": 7, \"skip\": \"a\\\\\\\"}]b\\\\\"},"
+  " \"tags\": [\"a\", \"b\", \"c\"], \"a/b\": {\"m~n\": 1}, \"0\": \"zero\","
+  " \"skipped\": [{\"x\": \"]}\"}, \"\\\"\"]}";
+
+static value project(const char* document, const Projection<>& projection) {
+  stringstream s(document);
+  return reader().project(s, projection);
+}
+
+//! Pointers are unescaped, digits select members as well as elements, and paths below a whole value are covered by it.
+static void testPointers() {
+  value all = project(json, Projection<>({ "" }));
+  JSONCXX_CHECK(all.size() == 5);
+  JSONCXX_CHECK(all[key("user")][key("skip")].asString() == "a\\\"}]b\\");
+
+  value escaped = project(json, Projection<>({ "/a~1b/m~0n", "/0" }));
+  JSONCXX_CHECK(escaped.size() == 2 && escaped[key("a/b")][key("m~n")].asNatural() == 1);
+  JSONCXX_CHECK(escaped[key("0")].asString() == "zero");
+
+  value user = project(json, Projection<>({ "/user/id", "/user" }));
+  JSONCXX_CHECK(user[key("user")].size() == 3);
+  JSONCXX_CHECK(user[key("user")][key("id")].asNatural() == 7);
+
+  JSONCXX_CHECK_THROWS(Projection<>({ "user" }), parsing_error);
+  JSONCXX_CHECK_THROWS(Projection<>({ "/a~2" }), parsing_error);
+  JSONCXX_CHECK_THROWS(Projection<>({ "/a~" }), parsing_error);
+}
+
+//! Strings and nested containers holding brackets and quotation marks are skipped whole.
+static void testSkipped() {
+  value tags = project(json, Projection<>({ "/tags/1" }));
+  JSONCXX_CHECK(tags.size() == 1 && tags[key("tags")].size() == 2);
+  JSONCXX_CHECK(tags[key("tags")][size_t(1)].asString() == "b");
+
+  value name = project(json, Projection<>({ "/user/name", "/skipped/1" }));
+  JSONCXX_CHECK(name[key("user")].size() == 1 && name[key("user")][key("name")].asString() == "seonho");
+  JSONCXX_CHECK(name[key("skipped")].size() == 2 && name[key("skipped")][size_t(1)].asString() == "\"");
+
+  value nothing = project(json, Projection<>());
+  JSONCXX_CHECK(nothing.type() == ObjectType && nothing.size() == 0);
+}
+
+//! Paths to missing values, or through values which are not containers, select nothing in arrays as in objects.
+/*! Elements left out are replaced by null only before an element which is materialized, to keep its index.
+ */
+static void testMissing() {
+  value tags = project(json, Projection<>({ "/tags/2" }));
+  JSONCXX_CHECK(tags[key("tags")].size() == 3);
+  JSONCXX_CHECK(tags[key("tags")][size_t(0)].type() == NullType && tags[key("tags")][size_t(2)].asString() == "c");
+
+  value beyond = project(json, Projection<>({ "/nobody/name", "/tags/9" }));
+  JSONCXX_CHECK(beyond.size() == 1 && beyond[key("tags")].size() == 0);
+
+  // through a scalar
+  value member = project(json, Projection<>({ "/user/name/x" }));
+  JSONCXX_CHECK(member[key("user")].size() == 0);
+  value element = project("[1, 2]", Projection<>({ "/1/x" }));
+  JSONCXX_CHECK(element.type() == ArrayType && element.size() == 0);
+
+  // a later element which is materialized keeps its index
+  value kept = project("[1, {\"x\": 2}, 3, [4]]", Projection<>({ "/0/x", "/1/x", "/2/x" }));
+  JSONCXX_CHECK(kept.size() == 2);
+  JSONCXX_CHECK(kept[size_t(0)].type() == NullType && kept[size_t(1)][key("x")].asNatural() == 2);
+
+  // through a container of the other kind
+  value object = project(json, Projection<>({ "/user/0" }));
+  JSONCXX_CHECK(object[key("user")].size() == 0);
+  value array = project(json, Projection<>({ "/tags/name" }));
+  JSONCXX_CHECK(array[key("tags")].size() == 0);
+
+  value root = project("\"text\"", Projection<>({ "/a" }));
+  JSONCXX_CHECK(root.type() == NullType);
+}
+
+//! The containers on the paths are checked, while the values skipped are not validated.
+static void testMalformed() {
+  Projection<> projection({ "/a/b" });
+  JSONCXX_CHECK_THROWS(project("{\"a\": {\"b\": tru}}", projection), parsing_error);
+  JSONCXX_CHECK_THROWS(project("{\"a\" {\"b\": 1}}", projection), parsing_error);
+  JSONCXX_CHECK_THROWS(project("{\"x\": \"abc\\", projection), parsing_error);
+  JSONCXX_CHECK_THROWS(project("{\"x\": \"abc\\\"}", projection), parsing_error);
+  JSONCXX_CHECK_THROWS(project("{\"x\": [1, 2 \"a\": 1}", projection), parsing_error);
+
+  // empty members and elements which are skipped
+  JSONCXX_CHECK_THROWS(project("{\"x\":}", projection), parsing_error);
+  JSONCXX_CHECK_THROWS(project("{\"x\": 1, }", projection), parsing_error);
+  JSONCXX_CHECK_THROWS(project("{\"a\": [1,]}", Projection<>({ "/a/3" })), parsing_error);
+  JSONCXX_CHECK_THROWS(project("[,1]", Projection<>({ "/1" })), parsing_error);
+  JSONCXX_CHECK_THROWS(project("", projection), parsing_error);
+
+  // the contents of a skipped value are not validated
+  value lenient = project("{\"x\": [1 2 tru], \"a\": {\"b\": 1}}", projection);
+  JSONCXX_CHECK(lenient[key("a")][key("b")].asNatural() == 1);
+
+  reader r;
+  stringstream bad("[1, 2");
+  JSONCXX_CHECK_THROWS(r.project(bad, projection), parsing_error);
+  stringstream good("{\"a\": {\"b\": [true]}}");
+  value v = r.project(good, projection);
+  JSONCXX_CHECK(v[key("a")][key("b")].size() == 1);
+}
+
+int main() {
+  testPointers();
+  testSkipped();
+  testMissing();
+  testMalformed();
+  return report("projection");
+}
@@ -0,0 +1,148 @@
+/**
+ *  @file   resource.cpp
+ *  @brief    Test driver of values allocated from a std::pmr::memory_resource, which needs C++17.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#include "jsoncxx.hpp"
+#include "check.hpp"
+
+#include <map>
+#include <string>
+#include <utility>
+
+using namespace jsoncxx;
+
+#ifdef JSONCXX_MEMORY_RESOURCE
+//! Resource which counts its allocations and checks that each is deallocated once with its size and alignment.
+struct CountingResource : public std::pmr::memory_resource {
+  CountingResource() : allocations_(0), mismatches_(0) {}
+
+  void* do_allocate(size_t size, size_t align) override {
+    void* p = std::pmr::new_delete_resource()->allocate(size, align);
+    blocks_[p] = std::make_pair(size, align);
+    ++allocations_;
+    return p;
+  }
+
+  void do_deallocate(void* p, size_t size, size_t align) override {
+    std::map<void*, std::pair<size_t, size_t> >::iterator it = blocks_.find(p);
+    if (it == blocks_.end() || it->second != std::make_pair(size, align))
+      ++mismatches_;
+    else
+      blocks_.erase(it);
+    std::pmr::new_delete_resource()->deallocate(p, size, align);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+  //! Get the number of blocks not deallocated yet.
+  size_t outstanding() const { return blocks_.size(); }
+
+  std::map<void*, std::pair<size_t, size_t> > blocks_;
+  size_t allocations_;
+  size_t mismatches_;   //!< Deallocations of unknown blocks, or with another size or alignment.
+};
+
+//! Strings and containers of a parsed tree are returned to the resource when the tree is destroyed.
+static void testParsed() {
+  CountingResource resource;
+  {
+    value root;
+    stringstream s("{\"name\": \"a string which is too long to be stored in place\","
+                   " \"list\": [1, [2, 3], {\"nested\": \"another string which is allocated\"}],"
+                   " \"a name which is too long to be stored in place\": {}}");
+    JSONCXX_CHECK(reader().tryParse(s, root, &resource));
+    JSONCXX_CHECK(root.size() == 3 && root[std::string("list")][size_t(2)].size() == 1);
+    JSONCXX_CHECK(resource.allocations_ > 0 && resource.outstanding() > 0);
+  }
+  JSONCXX_CHECK(resource.outstanding() == 0);
+  JSONCXX_CHECK(resource.mismatches_ == 0);
+
+  // clear() returns them as well, and a failed parse returns what it allocated
+  value root;
+  stringstream s("[\"a string which is too long to be stored in place\", [[], {}]]");
+  JSONCXX_CHECK(reader().tryParse(s, root, &resource));
+  root.clear();
+  JSONCXX_CHECK(resource.outstanding() == 0);
+
+  stringstream broken("[\"a string which is too long to be stored in place\", [[], {}], tru]");
+  JSONCXX_CHECK(!reader().tryParse(broken, root, &resource));
+  JSONCXX_CHECK(root.type() == NullType && resource.outstanding() == 0);
+  JSONCXX_CHECK(resource.mismatches_ == 0);
+}
+
+//! Strings which fit in place never touch the resource, whether created or parsed.
+static void testShortStrings() {
+  // characters which fit in place of the pointer and the length, less the null terminator
+  const size_t capacity = sizeof(const char*) + 2 * sizeof(size_type) - 2;
+  CountingResource resource;
+  std::string str;
+  for (size_t length = 0; length <= 40; ++length, str += 'x') {
+    const size_t before = resource.allocations_;
+    {
+      value v(str.c_str(), (size_type)str.size(), &resource);
+      JSONCXX_CHECK(v.asString() == str);
+    }
+    JSONCXX_CHECK((resource.allocations_ == before) == (length <= capacity));
+  }
+  JSONCXX_CHECK(resource.outstanding() == 0);
+
+  CountingResource parsing;
+  value root;
+  stringstream s("\"short\"");
+  JSONCXX_CHECK(reader().tryParse(s, root, &parsing));
+  JSONCXX_CHECK(root.asString() == "short" && parsing.allocations_ == 0);
+
+  // short names of members take no memory beyond that of the members
+  CountingResource names, longNames;
+  stringstream shortKeys("{\"a\": 1, \"b\": 2, \"c\": 3}");
+  stringstream longKeys("{\"a name too long to fit in place\": 1, \"b name too long to fit in place\": 2,"
+                        " \"c name too long to fit in place\": 3}");
+  JSONCXX_CHECK(reader().tryParse(shortKeys, root, &names));
+  JSONCXX_CHECK(reader().tryParse(longKeys, root, &longNames));
+  JSONCXX_CHECK(longNames.allocations_ == names.allocations_ + 3);
+  root = value();
+  JSONCXX_CHECK(names.outstanding() == 0 && longNames.outstanding() == 0);
+}
+
+//! Containers created with the resource return every buffer they grow through, and copies of them use the heap.
+static void testContainers() {
+  CountingResource resource;
+  {
+    value list(ArrayType, &resource);
+    for (int i = 0; i < 1000; ++i)
+      list.append(value(i));
+    const size_t allocations = resource.allocations_;
+    JSONCXX_CHECK(allocations > 1 && resource.outstanding() == 2);  // the storage and the elements
+
+    value object(ObjectType, &resource);
+    for (int i = 0; i < 100; ++i)
+      object[std::to_string(i) + " is a name which is too long to be stored in place"] = i;
+
+    value copy = list;
+    copy.append(value(object));
+    JSONCXX_CHECK(resource.outstanding() == 2 + 1 + 100 * 2);  // storage, and a node and a name per member
+
+    // assignment returns the memory of the replaced value
+    object = value(1);
+    JSONCXX_CHECK(resource.outstanding() == 2);
+    value moved(std::move(list));
+    JSONCXX_CHECK(moved.size() == 1000 && resource.outstanding() == 2);
+  }
+  JSONCXX_CHECK(resource.outstanding() == 0);
+  JSONCXX_CHECK(resource.mismatches_ == 0);
+}
+#endif
+
+int main() {
+#ifdef JSONCXX_MEMORY_RESOURCE
+  testParsed();
+  testShortStrings();
+  testContainers();
+#endif
+  return report("resource");
+}
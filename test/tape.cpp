@@ -0,0 +1,200 @@
+/**
+ *  @file   tape.cpp
+ *  @brief    Test driver of TapeDocument and TapeValue.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#include "jsoncxx.hpp"
+#include "check.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace jsoncxx;
+
+static std::string number(real r) {
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%.17g", r);
+  return buffer;
+}
+
+//! Handler which writes the events of a reader as text.
+struct EventHandler : public BaseHandler<> {
+  void null()                 { events_ += "n,"; }
+  void boolean(bool b)        { events_ += b ? "t," : "f,"; }
+  void number(natural n)      { events_ += ::number((real)n) + ","; }
+  void number(real r)         { events_ += ::number(r) + ","; }
+  void string(const char* str, size_type length, bool) { events_ += "\"" + std::string(str, length) + "\","; }
+  void key(const char* str, size_type length, bool copy) { string(str, length, copy); }
+  void startObject()          { events_ += "{,"; }
+  void endObject(size_type count) { events_ += "}" + std::to_string(count) + ","; }
+  void startArray()           { events_ += "[,"; }
+  void endArray(size_type count)  { events_ += "]" + std::to_string(count) + ","; }
+
+  std::string events_;
+};
+
+//! Write the events which a reader would give for a value of the tape.
+static void walk(const TapeValue<>& v, std::string& events) {
+  switch (v.type()) {
+  case NullType:    events += "n,"; break;
+  case TrueType:    events += "t,"; break;
+  case FalseType:   events += "f,"; break;
+  case NumberType:  events += number(v.asReal()) + ","; break;
+  case StringType:  events += "\"" + v.asString().str() + "\","; break;
+  case ArrayType:
+    events += "[,";
+    for (TapeValue<>::const_iterator itr = v.begin(); itr != v.end(); ++itr)
+      walk(*itr, events);
+    events += "]" + std::to_string(v.size()) + ",";
+    break;
+  case ObjectType:
+    events += "{,";
+    for (TapeValue<>::const_iterator itr = v.begin(); itr != v.end(); ++itr) {
+      events += "\"" + itr.key().str() + "\",";
+      walk(*itr, events);
+    }
+    events += "}" + std::to_string(v.size()) + ",";
+    break;
+  }
+}
+
+//! Walking the tape gives the events it was built from, with containers skipped at once between siblings.
+static void testWalk() {
+  const char* documents[] = {
+    "0", "-1.5e300", "\"\"", "true", "null", "[]", "{}", "[[], {}, [[]], {\"\": {}}]",
+    "{\"user\": {\"name\": \"seonho\", \"tags\": [\"a\", \"b\"]}, \"count\": 3, \"ratio\": 0.5, \"ok\": true, \"none\": null}",
+    "[1, 2.5, [3, [4.5, {\"a\": [5]}], 6], {\"b\": 7, \"c\": [8.5, 9]}, 10, \"s\", -11]",
+  };
+  for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); ++i) {
+    TapeDocument<> doc;
+    doc.parse(documents[i]);
+    EventHandler handler;
+    stringstream s(documents[i]);
+    reader().parse(s, handler);
+    std::string events;
+    walk(doc.root(), events);
+    JSONCXX_CHECK(events == handler.events_);
+  }
+
+  // elements after containers and two-word numbers are found by skipping
+  TapeDocument<> doc;
+  doc.parse(documents[9]);
+  JSONCXX_CHECK(doc.root()[3]["c"][1].asNatural() == 9);
+  JSONCXX_CHECK(doc.root()[6].asNatural() == -11);
+  JSONCXX_CHECK(doc.root()[2][1][1]["a"][0].asNatural() == 5);
+  JSONCXX_CHECK(doc.root()[1].asReal() == 2.5 && doc.root()[1].asNatural() == 2);
+  JSONCXX_CHECK(!doc.root()[7].exists());
+}
+
+//! Numbers keep all their bits in the word after their tag, and strings keep their length and null characters.
+static void testScalars() {
+  TapeDocument<> doc;
+  doc.parse("[-9223372036854775808, 9223372036854775807, -1, -0, 4.9406564584124654e-324, 1.7976931348623157e308]");
+  JSONCXX_CHECK(doc.root()[0].asNatural() == std::numeric_limits<natural>::min());
+  JSONCXX_CHECK(doc.root()[1].asNatural() == std::numeric_limits<natural>::max());
+  JSONCXX_CHECK(doc.root()[2].asNatural() == -1 && doc.root()[2].asReal() == -1.0);
+  JSONCXX_CHECK(doc.root()[3].asReal() == 0);
+  JSONCXX_CHECK(doc.root()[4].asReal() == std::numeric_limits<real>::denorm_min());
+  JSONCXX_CHECK(doc.root()[5].asReal() == std::numeric_limits<real>::max());
+  JSONCXX_CHECK(doc.tapeSize() == 2 + 6 * 2);
+
+  const std::string strings = "{\"a\\u0000b\": \"\\u0000\", \"\": \"\", \"long\": \"" + std::string(1000, 'x') + "\\n\"}";
+  doc.parse(strings.c_str());
+  const std::string nul(1, '\0');
+  JSONCXX_CHECK(doc.root()[std::string("a") + nul + "b"].asString().str() == nul);
+  JSONCXX_CHECK(doc.root()[""].exists() && doc.root()[""].asString().length() == 0);
+  JSONCXX_CHECK(doc.root()["a"].exists() == false);
+
+  StringRef<char> str = doc.root()["long"].asString();
+  JSONCXX_CHECK(str.length() == 1001 && str.str() == std::string(1000, 'x') + "\n" && str.data()[1001] == '\0');
+}
+
+//! Strings are copied into the arena, so a document read in place does not refer to the buffer.
+static void testInsitu() {
+  std::string json = "{\"name\": \"in \\\"place\\\"\", \"list\": [\"a\", \"b\"]}";
+  std::vector<char> buffer(json.begin(), json.end());
+  buffer.push_back('\0');
+
+  TapeDocument<> doc;
+  insitustringstream s(&buffer[0]);
+  doc.parse<ParseInsituFlag>(s);
+  std::fill(buffer.begin(), buffer.end(), '?');
+
+  JSONCXX_CHECK(doc.root()["name"].asString() == "in \"place\"");
+  JSONCXX_CHECK(doc.root()["list"][1].asString() == "b");
+  const char* str = doc.root()["name"].asString().data();
+  JSONCXX_CHECK(str < &buffer[0] || str >= &buffer[0] + buffer.size());
+}
+
+//! The count of a container saturates in its word, and is then counted by walking its elements.
+static void testSaturatedCount() {
+  const size_type counts[] = { 0xFFFFFE, 0xFFFFFF, 0x1000005 };
+  TapeDocument<> doc;
+  for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i) {
+    TapeHandler<> handler(doc);
+    handler.startArray();
+    for (size_type j = 0; j < counts[i]; ++j)
+      handler.null();
+    handler.endArray(counts[i]);
+    JSONCXX_CHECK(doc.root().size() == counts[i]);
+    JSONCXX_CHECK(doc.tapeSize() == counts[i] + 2);
+  }
+}
+
+//! Lookups of missing values and of values of another type give a missing value, which can be chained.
+static void testMissing() {
+  TapeDocument<> doc;
+  JSONCXX_CHECK(doc.empty() && !doc.root().exists());
+
+  doc.parse("{\"count\": 3, \"tags\": [\"a\", \"b\"], \"user\": {\"ab\": 1}, \"none\": null}");
+  TapeValue<> root = doc.root();
+
+  TapeValue<> missing = root["nobody"]["name"];
+  JSONCXX_CHECK(!missing.exists() && missing.type() == NullType);
+  JSONCXX_CHECK(missing.size() == 0 && missing.empty());
+  JSONCXX_CHECK(!missing[0]["x"].exists());
+
+  JSONCXX_CHECK(root["none"].exists() && root["none"].type() == NullType);
+  JSONCXX_CHECK(!root["tags"][2].exists());
+  JSONCXX_CHECK(!root["count"]["x"].exists() && root["count"].size() == 0 && root["count"].empty());
+  JSONCXX_CHECK(!root["user"][0].exists());
+  JSONCXX_CHECK(!root["tags"]["a"].exists());
+  JSONCXX_CHECK(!root["user"]["a"].exists() && !root["user"]["abc"].exists());
+}
+
+//! A failed parse leaves the document empty, and clear() keeps the buffers for the next one.
+static void testReuse() {
+  TapeDocument<> doc;
+  doc.parse("{\"a\": [1, 2, 3]}");
+  JSONCXX_CHECK_THROWS(doc.parse("{\"a\": [1, 2,"), parsing_error);
+  JSONCXX_CHECK(doc.empty() && doc.tapeSize() == 0);
+  JSONCXX_CHECK(!doc.root().exists() && doc.root().size() == 0);
+  JSONCXX_CHECK(!doc.root()["a"][0].exists());
+
+  doc.parse("[1, [2, 3], 4]");
+  JSONCXX_CHECK(!doc.empty());
+  JSONCXX_CHECK(doc.root()[1][1].asNatural() == 3 && doc.root()[2].asNatural() == 4);
+
+  // a second document replaces the first, strings included
+  doc.parse("[\"second\"]");
+  JSONCXX_CHECK(doc.root().size() == 1 && doc.root()[0].asString() == "second");
+  doc.clear();
+  JSONCXX_CHECK(doc.empty());
+}
+
+int main() {
+  testWalk();
+  testScalars();
+  testInsitu();
+  testSaturatedCount();
+  testMissing();
+  testReuse();
+  return report("tape");
+}
@@ -0,0 +1,196 @@
+/**
+ *  @file   transcode.cpp
+ *  @brief    Test driver of the SIMD conversion of UTF-16 and UTF-32 to UTF-8 against the scalar one.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#include "jsoncxx.hpp"
+#include "check.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace jsoncxx;
+
+typedef std::vector<char32_t> characters;
+typedef Transcoder<UTF16<char16_t>, UTF8<char> > Transcoder16;
+typedef Transcoder<UTF32<char32_t>, UTF8<char> > Transcoder32;
+
+//! Encode characters as UTF-16, where a surrogate is kept as a lone unit.
+static std::u16string toUTF16(const characters& chars) {
+  std::u16string str;
+  for (size_t i = 0; i < chars.size(); ++i) {
+    if (chars[i] >= 0x10000) {
+      str += (char16_t)(0xD800 + ((chars[i] - 0x10000) >> 10));
+      str += (char16_t)(0xDC00 + ((chars[i] - 0x10000) & 0x3FF));
+    } else
+      str += (char16_t)chars[i];
+  }
+  return str;
+}
+
+//! Encode characters as UTF-8, where a surrogate or a character beyond U+10FFFF is replaced by U+FFFD.
+static std::string toUTF8(const characters& chars, bool& valid) {
+  std::string str;
+  valid = true;
+  for (size_t i = 0; i < chars.size(); ++i) {
+    char32_t c = chars[i];
+    if ((c >= 0xD800 && c <= 0xDFFF) || c > 0x10FFFF) {
+      c = 0xFFFD;
+      valid = false;
+    }
+    if (c < 0x80)
+      str += (char)c;
+    else if (c < 0x800) {
+      str += (char)(0xC0 | (c >> 6));
+      str += (char)(0x80 | (c & 0x3F));
+    } else if (c < 0x10000) {
+      str += (char)(0xE0 | (c >> 12));
+      str += (char)(0x80 | ((c >> 6) & 0x3F));
+      str += (char)(0x80 | (c & 0x3F));
+    } else {
+      str += (char)(0xF0 | (c >> 18));
+      str += (char)(0x80 | ((c >> 12) & 0x3F));
+      str += (char)(0x80 | ((c >> 6) & 0x3F));
+      str += (char)(0x80 | (c & 0x3F));
+    }
+  }
+  return str;
+}
+
+//! Convert characters from UTF-16 and UTF-32 with every kernel, and check the bytes and the validity of each.
+static bool convert(const characters& chars) {
+  bool expectedValid;
+  const std::string expected = toUTF8(chars, expectedValid);
+  const std::u16string utf16 = toUTF16(chars);
+  const std::u32string utf32(chars.begin(), chars.end());
+  bool same = true;
+
+  std::vector<char> buffer(utf32.size() * 4 + 16);
+  bool valid = true;
+  char* end = TranscodeUTF16ToUTF8_Scalar(utf16.data(), utf16.data() + utf16.size(), &buffer[0], valid);
+  same = same && std::string(&buffer[0], end) == expected && valid == expectedValid;
+  valid = true;
+  end = TranscodeUTF32ToUTF8_Scalar(utf32.data(), utf32.data() + utf32.size(), &buffer[0], valid);
+  same = same && std::string(&buffer[0], end) == expected && valid == expectedValid;
+
+#ifdef JSONCXX_SIMD
+  if (GetSimdLevel() >= SimdSSE42) {
+    valid = true;
+    end = TranscodeUTF16ToUTF8_SSE42(utf16.data(), utf16.data() + utf16.size(), &buffer[0], valid);
+    same = same && std::string(&buffer[0], end) == expected && valid == expectedValid;
+    valid = true;
+    end = TranscodeUTF32ToUTF8_SSE42(utf32.data(), utf32.data() + utf32.size(), &buffer[0], valid);
+    same = same && std::string(&buffer[0], end) == expected && valid == expectedValid;
+  }
+#endif
+
+  // characters are appended to the output
+  std::string out = "x";
+  same = same && Transcoder16::Transcode(utf16.data(), utf16.size(), out) == expectedValid;
+  same = same && out == "x" + expected;
+  out = "y";
+  same = same && Transcoder32::Transcode(utf32.data(), utf32.size(), out) == expectedValid;
+  same = same && out == "y" + expected;
+  return same;
+}
+
+//! Blocks of 8 units mixing ASCII with 2-byte characters in every pattern, and with 3-byte characters, at every alignment.
+static void testMixedBlocks() {
+  bool same = true;
+  for (unsigned mask = 0; mask < 256; ++mask) {
+    for (size_t shift = 0; shift < 8; ++shift) {
+      characters chars(shift, 'a');
+      for (unsigned i = 0; i < 16; ++i)
+        chars.push_back(mask & (1u << (i % 8)) ? (char32_t)('A' + i) : (char32_t)(0x80 + mask * 7 + i));
+      same = same && convert(chars);
+    }
+  }
+  JSONCXX_CHECK(same);
+
+  const char32_t three[] = { 0x800, 0xFFFF, 0xD7FF, 0xE000, 0x20AC, 0xAC00, 0xFFFD, 0x4E2D };
+  characters threes(three, three + 8);
+  JSONCXX_CHECK(convert(threes));
+  threes.insert(threes.end(), three, three + 8);
+  JSONCXX_CHECK(convert(threes));
+
+  // 3-byte characters with ASCII or 2-byte ones in the same block
+  for (size_t i = 0; i < 8; ++i) {
+    characters mixed(three, three + 8);
+    mixed[i] = 'z';
+    JSONCXX_CHECK(convert(mixed));
+    mixed[i] = 0x7FF;
+    JSONCXX_CHECK(convert(mixed));
+  }
+}
+
+//! A surrogate pair which straddles the edge of a block of 8 units, or lies anywhere in it.
+static void testSurrogatePairs() {
+  for (size_t before = 0; before < 20; ++before) {
+    characters ascii(before, 'a'), wide(before, 0xE9), three(before, 0x20AC);
+    ascii.push_back(0x1F600);
+    wide.push_back(0x10000);
+    three.push_back(0x10FFFF);
+    ascii.resize(24, 'b');
+    wide.resize(24, 0x7FF);
+    three.resize(24, 0x800);
+    JSONCXX_CHECK(convert(ascii));
+    JSONCXX_CHECK(convert(wide));
+    JSONCXX_CHECK(convert(three));
+  }
+
+  characters pairs(9, 0x1F600);  // 18 units
+  JSONCXX_CHECK(convert(pairs));
+}
+
+//! Lone surrogates are replaced by U+FFFD and make the input invalid, wherever they are.
+static void testLoneSurrogates() {
+  const char32_t lone[] = { 0xD800, 0xDBFF, 0xDC00, 0xDFFF };
+  for (size_t i = 0; i < 4; ++i) {
+    for (size_t at = 0; at < 17; ++at) {
+      characters chars(17, 'a');
+      chars[at] = lone[i];
+      JSONCXX_CHECK(convert(chars));
+      chars.resize(at + 1);   // at the end of the input
+      JSONCXX_CHECK(convert(chars));
+    }
+  }
+
+  // a high surrogate followed by another high surrogate, and by a character which is not a surrogate
+  const char32_t highs[] = { 'a', 0xD83D, 0xD83D, 0xE9, 'b', 0xDBFF, 'c', 'd', 'e', 'f' };
+  JSONCXX_CHECK(convert(characters(highs, highs + 10)));
+
+  // UTF-32 is also invalid beyond U+10FFFF
+  std::u32string beyond(10, U'a');
+  beyond[3] = 0x110000;
+  std::string out;
+  JSONCXX_CHECK(!Transcoder32::Transcode(beyond.data(), beyond.size(), out));
+  JSONCXX_CHECK(out == "aaa\xEF\xBF\xBD" "aaaaaa");
+}
+
+//! Inputs shorter than a block, and tails shorter than a block after whole ones.
+static void testTails() {
+  const char32_t pieces[] = { 'a', 0xE9, 0x20AC, 0x1F600 };
+  for (size_t length = 0; length < 24; ++length) {
+    for (size_t kind = 0; kind < 4; ++kind) {
+      characters chars;
+      for (size_t i = 0; i < length; ++i)
+        chars.push_back(pieces[(kind + i * (kind + 1)) % 4]);
+      JSONCXX_CHECK(convert(chars));
+    }
+  }
+
+  std::string out = "kept";
+  JSONCXX_CHECK(Transcoder16::Transcode(u"", 0, out) && out == "kept");
+}
+
+int main() {
+  testMixedBlocks();
+  testSurrogatePairs();
+  testLoneSurrogates();
+  testTails();
+  return report("transcode");
+}
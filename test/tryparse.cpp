@@ -0,0 +1,140 @@
+/**
+ *  @file   tryparse.cpp
+ *  @brief    Test driver of Reader::tryParse and ParseResult.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#include "jsoncxx.hpp"
+#include "check.hpp"
+
+#include <new>
+#include <stdexcept>
+#include <string>
+
+using namespace jsoncxx;
+
+static ParseResult tryParse(const char* json) {
+  stringstream s(json);
+  BaseHandler<> handler;
+  return reader().tryParse(s, handler);
+}
+
+//! Each kind of error is reported with its code and the offset where it was found.
+static void testCodes() {
+  struct Case {
+    const char*     json;
+    ParseErrorCode  code;
+    size_t          offset;
+  } cases[] = {
+    { "[1, 2]",               ParseErrorNone,                           0 },
+    { "",                     ParseErrorValueInvalid,                   0 },
+    { "  nul",                ParseErrorValueInvalid,                   2 },
+    { "[1 2]",                ParseErrorArrayMissCommaOrSquareBracket,  3 },
+    { "{1: 2}",               ParseErrorObjectMissName,                 1 },
+    { "{\"a\" 2}",            ParseErrorObjectMissColon,                5 },
+    { "{\"a\": 2 ]",          ParseErrorObjectMissCommaOrCurlyBracket,  8 },
+    { "\"abc",                ParseErrorStringMissQuotationMark,        4 },
+    { "\"a\tb\"",             ParseErrorStringInvalidControlCharacter,  2 },
+    { "\"a\\qb\"",            ParseErrorStringEscapeInvalid,            3 },
+    { "\"\\u12g4\"",          ParseErrorStringUnicodeEscapeInvalidHex,  5 },
+    { "\"\\uDC00\"",          ParseErrorStringUnicodeSurrogateInvalid,  2 },
+    { "1e400",                ParseErrorNumberTooBig,                   5 },
+    { "1.",                   ParseErrorNumberMissFraction,             2 },
+    { "1e+",                  ParseErrorNumberMissExponent,             3 },
+  };
+
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+    ParseResult result = tryParse(cases[i].json);
+    JSONCXX_CHECK(result.code == cases[i].code);
+    JSONCXX_CHECK(result.offset == cases[i].offset);
+    JSONCXX_CHECK(bool(result) == (cases[i].code == ParseErrorNone));
+  }
+}
+
+//! The line and column are only counted by describe().
+static void testDescribe() {
+  const char* json = "{\n  \"a\": [1,\n  2 3]\n}";
+  ParseResult result = tryParse(json);
+  JSONCXX_CHECK(result.code == ParseErrorArrayMissCommaOrSquareBracket);
+  JSONCXX_CHECK(result.describe(json) == std::string("line 3, column 5: ") + result.message());
+}
+
+//! The value is only assigned when parsing succeeds.
+static void testValue() {
+  value root("unchanged");
+  stringstream bad("[1, {\"a\": tru}]");
+  ParseResult result = reader().tryParse(bad, root);
+  JSONCXX_CHECK(!result && result.code == ParseErrorValueInvalid && result.offset == 10);
+  JSONCXX_CHECK(root.type() == StringType && root.asString() == "unchanged");
+
+  stringstream good("[1, {\"a\": true}]");
+  JSONCXX_CHECK(reader().tryParse(good, root));
+  JSONCXX_CHECK(root.type() == ArrayType && root.size() == 2);
+
+  document doc;
+  stringstream broken("{\"a\": [1, 2}");
+  JSONCXX_CHECK(doc.tryParse(broken).code == ParseErrorArrayMissCommaOrSquareBracket);
+  JSONCXX_CHECK(doc.root().type() == NullType);
+}
+
+//! Handler which throws on null.
+struct ThrowingHandler : public BaseHandler<> {
+  void null() { throw std::runtime_error("null"); }
+};
+
+//! Exceptions of handlers reach the caller of parse() instead of terminating the program.
+static void testHandlerExceptions() {
+  reader r;
+  ThrowingHandler handler;
+  stringstream s("[1, {\"a\": null}]");
+  JSONCXX_CHECK_THROWS(r.parse(s, handler), std::runtime_error);
+
+  stringstream iterative("[[[null]]]");
+  JSONCXX_CHECK_THROWS(r.parse<ParseIterativeFlag>(iterative, handler), std::runtime_error);
+
+  stringstream after("[true]");
+  r.parse(after, handler);  // the reader is not left in the failed state
+  JSONCXX_CHECK(true);
+}
+
+#ifdef JSONCXX_MEMORY_RESOURCE
+//! Resource which runs out of memory after a number of allocations.
+struct ExhaustedResource : public std::pmr::memory_resource {
+  explicit ExhaustedResource(int allocations) : allocations_(allocations) {}
+
+  void* do_allocate(size_t size, size_t align) override {
+    if (allocations_-- <= 0)
+      throw std::bad_alloc();
+    return std::pmr::new_delete_resource()->allocate(size, align);
+  }
+  void do_deallocate(void* p, size_t size, size_t align) override {
+    std::pmr::new_delete_resource()->deallocate(p, size, align);
+  }
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+  int allocations_;
+};
+
+//! Running out of memory while building a value is thrown, not turned into an abort.
+static void testOutOfMemory() {
+  ExhaustedResource resource(2);
+  value root;
+  stringstream s("[[1], [2], [3], \"a string which does not fit in place\"]");
+  JSONCXX_CHECK_THROWS(reader().tryParse(s, root, &resource), std::bad_alloc);
+  JSONCXX_CHECK(root.type() == NullType);
+}
+#endif
+
+int main() {
+  testCodes();
+  testDescribe();
+  testValue();
+  testHandlerExceptions();
+#ifdef JSONCXX_MEMORY_RESOURCE
+  testOutOfMemory();
+#endif
+  return report("tryparse");
+}
@@ -0,0 +1,139 @@
+/**
+ *  @file   utf8.cpp
+ *  @brief    Test driver of the SIMD UTF-8 validation against the scalar one.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#include "jsoncxx.hpp"
+#include "check.hpp"
+
+#include <string>
+
+using namespace jsoncxx;
+
+//! A sequence of bytes and whether it is well-formed UTF-8.
+struct Sequence {
+  const char* bytes;
+  bool        valid;
+};
+
+static const Sequence sequences[] = {
+  { "\xC2\x80", true },             // U+0080
+  { "\xDF\xBF", true },             // U+07FF
+  { "\xE0\xA0\x80", true },         // U+0800
+  { "\xED\x9F\xBF", true },         // U+D7FF
+  { "\xEE\x80\x80", true },         // U+E000
+  { "\xEF\xBF\xBF", true },         // U+FFFF
+  { "\xF0\x90\x80\x80", true },     // U+10000
+  { "\xF4\x8F\xBF\xBF", true },     // U+10FFFF
+  { "\xC0\x80", false },            // overlong
+  { "\xC1\xBF", false },
+  { "\xE0\x80\x80", false },
+  { "\xE0\x9F\xBF", false },
+  { "\xF0\x80\x80\x80", false },
+  { "\xF0\x8F\xBF\xBF", false },
+  { "\xED\xA0\x80", false },        // surrogates
+  { "\xED\xBF\xBF", false },
+  { "\xF4\x90\x80\x80", false },    // beyond U+10FFFF
+  { "\xF5\x80\x80\x80", false },
+  { "\xF8\x88\x80\x80\x80", false },
+  { "\xFF", false },
+  { "\xC3", false },                // truncated
+  { "\xE2\x82", false },
+  { "\xF0\x9F\x98", false },
+  { "\xE2\x28\xA1", false },        // ASCII in a sequence
+  { "\x80", false },                // continuation bytes without a leading byte
+  { "\xC3\xA9\xA9", false },
+};
+
+//! Check a string with every kernel the host supports, and return whether they agree with the scalar one.
+static bool agree(const std::string& str, bool& valid) {
+  valid = ValidateUTF8_Scalar(str.data(), str.size());
+  bool same = ValidateUTF8(str.data(), str.size()) == valid;
+#ifdef JSONCXX_SIMD
+  if (GetSimdLevel() >= SimdSSE42)
+    same = same && ValidateUTF8_SSE42(str.data(), str.size()) == valid;
+  if (GetSimdLevel() >= SimdAVX2)
+    same = same && ValidateUTF8_AVX2(str.data(), str.size()) == valid;
+#endif
+  return same;
+}
+
+//! Each sequence is found at every offset across the boundaries of 16 and 32-byte blocks, followed by ASCII or not.
+static void testOffsets() {
+  for (size_t i = 0; i < sizeof(sequences) / sizeof(sequences[0]); ++i) {
+    const std::string bytes = sequences[i].bytes;
+    bool mismatch = false, wrong = false;
+    for (size_t offset = 0; offset <= 70; ++offset) {
+      const size_t after[] = { 0, 1, 3, 16, 33, 64 };
+      for (size_t j = 0; j < sizeof(after) / sizeof(after[0]); ++j) {
+        std::string str = std::string(offset, 'a') + bytes + std::string(after[j], 'b');
+        bool valid;
+        mismatch = mismatch || !agree(str, valid);
+        wrong = wrong || valid != sequences[i].valid;
+      }
+    }
+    JSONCXX_CHECK(!mismatch);
+    JSONCXX_CHECK(!wrong);
+  }
+}
+
+//! A sequence cut by the end of a block is an error even if whole ASCII blocks follow it.
+static void testIncompleteBeforeAscii() {
+  const char* leading[] = { "\xC3", "\xE2", "\xE2\x82", "\xF0", "\xF0\x9F", "\xF0\x9F\x98" };
+  for (size_t i = 0; i < sizeof(leading) / sizeof(leading[0]); ++i) {
+    const std::string bytes = leading[i];
+    const size_t blocks[] = { 16, 32, 64 };
+    for (size_t j = 0; j < sizeof(blocks) / sizeof(blocks[0]); ++j) {
+      std::string str = std::string(blocks[j] - bytes.size(), 'a') + bytes;
+      for (size_t k = 1; k <= 3; ++k) {
+        str += std::string(32, 'b');
+        bool valid;
+        JSONCXX_CHECK(agree(str, valid) && !valid);
+      }
+    }
+  }
+
+  // a sequence completed in the next block is not
+  bool valid;
+  JSONCXX_CHECK(agree(std::string(31, 'a') + "\xF0\x9F\x98\x80" + std::string(64, 'b'), valid) && valid);
+  JSONCXX_CHECK(agree(std::string(15, 'a') + "\xE2\x82\xAC" + std::string(16, 'b'), valid) && valid);
+}
+
+//! Next number of a linear congruential generator, so runs are repeatable.
+static unsigned nextRandom(unsigned& seed) {
+  seed = seed * 1103515245 + 12345;
+  return seed >> 16;
+}
+
+//! Random mixes of characters and of bytes are judged alike by every kernel.
+static void testRandom() {
+  const char* pieces[] = { "a", " ", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\xED\x9F\xBF", "\xF4\x8F\xBF\xBF" };
+  unsigned seed = 12345;
+  size_t invalid = 0;
+  bool mismatch = false;
+  for (int n = 0; n < 20000; ++n) {
+    std::string str;
+    size_t length = nextRandom(seed) & 127;
+    while (str.size() < length)
+      str += pieces[nextRandom(seed) % 7];
+    if (n % 2 && !str.empty()) // corrupt a byte
+      str[nextRandom(seed) % str.size()] = (char)(nextRandom(seed) & 0xFF);
+
+    bool valid;
+    mismatch = mismatch || !agree(str, valid);
+    invalid += !valid;
+  }
+  JSONCXX_CHECK(!mismatch);
+  JSONCXX_CHECK(invalid > 1000 && invalid < 10000);
+}
+
+int main() {
+  testOffsets();
+  testIncompleteBeforeAscii();
+  testRandom();
+  return report("utf8");
+}
@@ -0,0 +1,121 @@
+/**
+ *  @file   value.cpp
+ *  @brief    Test driver of strings stored in place of Value.
+ *  @author   seonho.oh@gmail.com
+ *  @date   2013-11-01
+ *  @copyright  2013-2015 seonho.oh@gmail.com
+ *  @version  1.0
+ */
+
+#include "jsoncxx.hpp"
+#include "check.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace jsoncxx;
+
+//! Strings of every length around the largest one stored in place survive copies, moves and assignments.
+static void testLengths() {
+  for (size_t length = 0; length <= 40; ++length) {
+    std::string str;
+    for (size_t i = 0; i < length; ++i)
+      str += (char)('a' + i % 26);
+
+    value owned(str);
+    JSONCXX_CHECK(owned.asString() == str);
+    JSONCXX_CHECK(owned.asString().length() == length && owned.asString().c_str()[length] == '\0');
+
+    value copied(owned);
+    value moved(std::move(copied));
+    JSONCXX_CHECK(moved.asString() == str && copied.type() == NullType);
+
+    value assigned(1);
+    assigned = moved;
+    JSONCXX_CHECK(assigned.asString() == str);
+    assigned = value("x");
+    JSONCXX_CHECK(assigned.asString() == "x" && moved.asString() == str);
+  }
+
+  // characters after a null character are kept
+  const char with_null[] = { 'a', '\0', 'b' };
+  value v(with_null, with_null + 3);
+  JSONCXX_CHECK(v.asString().length() == 3 && v.asString().str() == std::string(with_null, 3));
+}
+
+//! The characters of a string stay at the same address for the lifetime of the value, like std::string::c_str().
+static void testAddress() {
+  value small("short"), large("a string which is too long to be stored in place");
+  const char* s = small.asString().c_str();
+  const char* l = large.asString().c_str();
+
+  value other(small);
+  other = value("another");
+  JSONCXX_CHECK(small.asString().c_str() == s && std::string(s) == "short");
+  JSONCXX_CHECK(large.asString().c_str() == l && std::string(l) == "a string which is too long to be stored in place");
+
+  // Moving the value moves characters stored in place, so references must be taken again.
+  std::vector<value> values;
+  values.push_back(value("short"));
+  std::string kept = values[0].asString().str();
+  for (int i = 0; i < 100; ++i)
+    values.push_back(value("growth"));
+  JSONCXX_CHECK(values[0].asString() == kept);
+  JSONCXX_CHECK(values[0].asString().c_str() == values[0].asString().c_str());
+}
+
+//! Short names of members are compared and looked up like other names.
+static void testKeys() {
+  value object(ObjectType);
+  const char* names[] = { "", "a", "ab", "abcdefghijklmn", "abcdefghijklmno", "abcdefghijklmnopqrstuvwxyz" };
+  for (int i = 0; i < 6; ++i)
+    object[std::string(names[i])] = i;
+  JSONCXX_CHECK(object.size() == 6);
+  for (int i = 0; i < 6; ++i)
+    JSONCXX_CHECK(object[std::string(names[i])].asNatural() == i);
+  JSONCXX_CHECK(object[std::string("abcdefghijklm")].type() == NullType);  // added by the lookup
+
+  // names are ordered by hash, then by characters
+  JSONCXX_CHECK(!(value("abc") < value("abc")));
+  JSONCXX_CHECK((value("abc") < value("abd")) != (value("abd") < value("abc")));
+  JSONCXX_CHECK((value("b") < value("abcdefghijklmnopq")) != (value("abcdefghijklmnopq") < value("b")));
+}
+
+//! Parsed strings are stored in place when short, and refer to the buffer of in-situ parsing.
+static void testParsed() {
+  std::string source = "{\"a\": \"short\", \"b\": \"a string longer than a short one\", \"e\": \"\\u00e9\\n\"}";
+  stringstream s(source.c_str());
+  value copied = reader().parse(s);
+  JSONCXX_CHECK(copied[std::string("a")].asString() == "short");
+  JSONCXX_CHECK(copied[std::string("e")].asString() == "\xC3\xA9\n");
+
+  std::vector<char> buffer(source.begin(), source.end());
+  buffer.push_back('\0');
+  insitustringstream t(&buffer[0]);
+  value insitu = Reader<insitustringstream>().parse<ParseInsituFlag>(t);
+  const char* b = insitu[std::string("b")].asString().c_str();
+  JSONCXX_CHECK(b >= &buffer[0] && b < &buffer[0] + buffer.size());
+  JSONCXX_CHECK(insitu[std::string("b")].asString() == "a string longer than a short one");
+  JSONCXX_CHECK(insitu[std::string("e")].asString() == "\xC3\xA9\n");
+}
+
+//! Encodings of wider characters store fewer of them in place.
+static void testWideCharacters() {
+  typedef Value<UTF16<> > value16;
+  std::u16string str;
+  for (int length = 0; length <= 12; ++length, str += u'é') {
+    value16 v(str);
+    value16 moved(std::move(v));
+    JSONCXX_CHECK(moved.asString().str() == str);
+  }
+}
+
+int main() {
+  testLengths();
+  testAddress();
+  testKeys();
+  testParsed();
+  testWideCharacters();
+  return report("value");
+}
@@ -14,11 +14,14 @@
 #include <ostream>    // basic_ostream
 #include <vector>
 #include <map>
+#include <cstddef>    // nullptr_t
 #include <cstring>    // memset
 #include <algorithm>  // transform
 #include <iterator>   // ostream_iterator
 #include <type_traits>
 
+#include "arena.hpp"
+
 // Helper to determine whether there's a const_iterator for T.
 template<typename T>
 struct has_const_iterator {
@@ -58,6 +61,77 @@ enum NumericType : unsigned int {
   RealNumber,
 };
 
+//! Compute hash value of a sequence of characters (FNV-1a).
+template <typename CharType>
+inline size_t hashString(const CharType* str, size_t length) {
+  size_t h = sizeof(size_t) == 8 ? (size_t)14695981039346656037ULL : (size_t)2166136261U;
+  const size_t prime = sizeof(size_t) == 8 ? (size_t)1099511628211ULL : (size_t)16777619U;
+  for (size_t i = 0; i < length; i++)
+    h = (h ^ (size_t)str[i]) * prime;
+  return h;
+}
+
+//! Non-owning reference to a null-terminated sequence of characters.
+/*!
+ Strings of Value are exposed through this type, since they may be owned by the value
+ or refer to an external buffer (e.g. the source of in-situ parsing).
+ \tparam CharType Type of character.
+ */
+template <typename CharType>
+class StringRef {
+ public:
+  typedef CharType                      char_type;
+  typedef std::basic_string<char_type>  string;
+  typedef std::basic_ostream<char_type, std::char_traits<char_type> > ostream;
+
+  StringRef() : str_(emptyString()), length_(0) {}
+  StringRef(const char_type* str, size_type length) : str_(str), length_(length) {}
+  StringRef(const char_type* str) : str_(str), length_((size_type)std::char_traits<char_type>::length(str)) {}
+  StringRef(const string& str) : str_(str.c_str()), length_((size_type)str.size()) {}
+
+  inline const char_type* c_str() const { return str_; }
+  inline const char_type* data() const  { return str_; }
+  inline size_type size() const         { return length_; }
+  inline size_type length() const       { return length_; }
+  inline bool empty() const             { return length_ == 0; }
+
+  inline const char_type* begin() const { return str_; }
+  inline const char_type* end() const   { return str_ + length_; }
+
+  inline const char_type& operator[] (size_type index) const { return str_[index]; }
+
+  //! Copy characters to a new string.
+  inline string str() const             { return string(str_, length_); }
+  inline operator string() const        { return str(); }
+
+  int compare(const StringRef& other) const {
+    int r = std::char_traits<char_type>::compare(str_, other.str_, std::min(length_, other.length_));
+    if (r != 0)
+      return r;
+    return length_ < other.length_ ? -1 : (length_ > other.length_ ? 1 : 0);
+  }
+
+  friend bool operator == (const StringRef& lhs, const StringRef& rhs) {
+    return lhs.length_ == rhs.length_ && std::char_traits<char_type>::compare(lhs.str_, rhs.str_, lhs.length_) == 0;
+  }
+  friend bool operator != (const StringRef& lhs, const StringRef& rhs) { return !(lhs == rhs); }
+  friend bool operator <  (const StringRef& lhs, const StringRef& rhs) { return lhs.compare(rhs) < 0; }
+
+  friend ostream& operator << (ostream& os, const StringRef& ref) {
+    return os.write(ref.str_, ref.length_);
+  }
+
+  //! Empty null-terminated string.
+  static const char_type* emptyString() {
+    static const char_type emptystr[1] = { 0 };
+    return emptystr;
+  }
+
+ private:
+  const char_type* str_;
+  size_type        length_;
+};
+
 //! Represents a JSON value. Use value for UTF8 encoding.
 /*!
  A JSON value can be one of types. This class is a variant type supporting these types.
@@ -72,6 +146,7 @@ class Value {
   typedef typename Encoding::char_type  char_type;      //! Character type derived from Encoding.
   typedef Value<Encoding>         self_type;
   typedef std::basic_string<char_type>  string;     //! String type
+  typedef StringRef<char_type>          string_ref; //! Non-owning string type
   typedef std::basic_ostream<char_type, std::char_traits<char_type> > ostream;  //! Output stream type
 
  protected:
@@ -86,16 +161,43 @@ class Value {
     NumericType type_;
   };
 
+  //! Flags of string type value.
+  enum StringFlag : unsigned char {
+    OwnedString = 0,  //!< Characters are allocated and freed by the value.
+    RefString   = 1,  //!< Characters belong to an external buffer (e.g. in-situ parsing).
+    ResourceString = 2, //!< Characters are allocated from a MemoryResource, which is stored before them.
+    ShortString = 3,  //!< Characters are stored in the value itself, as Short.
+  };
+
   //! Represents a string type value.
   struct String {
-    string*   str_;
-    size_t      hash_;
+    const char_type*  str_;     //!< Null-terminated characters.
+    size_type         length_;
+    unsigned char     reserved_[sizeof(size_type) - 1];
+    unsigned char     flags_;   //!< StringFlag, at the same offset as in Short.
+    size_t            hash_;
+  };
+
+  //! Represents a string type value short enough to store its characters in place of the pointer and the length.
+  /*! The unit after the last one which fits holds the number of unused units, so it is the null terminator
+      of a string of the largest length.
+   */
+  struct Short {
+    enum { capacity = (sizeof(const char_type*) + 2 * sizeof(size_type) - 1) / sizeof(char_type) - 1 };
+
+    inline const char_type* str() const { return reinterpret_cast<const char_type*>(bytes_); }
+    inline char_type* str()             { return reinterpret_cast<char_type*>(bytes_); }
+    inline size_type length() const     { return (size_type)(capacity - str()[capacity]); }
+
+    unsigned char     bytes_[sizeof(const char_type*) + 2 * sizeof(size_type) - 1];
+    unsigned char     flags_;   //!< ShortString.
+    size_t            hash_;
   };
 
   //! Represents an array type value.
   struct Array {
     typedef Value<Encoding>                         elem_type;
-    typedef std::vector<elem_type>                  storage_type;
+    typedef std::vector<elem_type, ValueAllocator<elem_type> > storage_type;
     typedef typename storage_type::iterator         iterator;
     typedef typename storage_type::const_iterator   const_iterator;
 
@@ -120,20 +222,20 @@ class Value {
   struct Object {
     typedef Value<Encoding>                         key_type;
     typedef Value<Encoding>                         value_type;
-    typedef std::map<key_type, value_type>          storage_type;
+    typedef std::map<key_type, value_type, std::less<key_type>,
+                     ValueAllocator<std::pair<const key_type, value_type> > > storage_type;
     typedef typename storage_type::iterator         iterator;
     typedef typename storage_type::const_iterator   const_iterator;
 
     value_type& operator[] (const string& key) {
       key_type _key = make_key(key);
       auto itr = members_->find(_key);
-      if (itr != members_->end()) {
-        _key.clear();
+      if (itr != members_->end())
         return itr->second;
-      }
 
-      // R-value reference
-      auto bi = members_->emplace(std::make_pair(std::move(_key), std::move(value_type())));
+      // R-value reference; the name is allocated with the members
+      key_type name(key.c_str(), (size_type)key.size(), members_->get_allocator().resource());
+      auto bi = members_->emplace(std::make_pair(std::move(name), std::move(value_type())));
       assert(bi.second); // is it possible?
 
       return ((*(bi.first)).second);
@@ -142,16 +244,15 @@ class Value {
     const value_type& operator[] (const string& key) const {
       key_type _key = make_key(key);
       auto itr = members_->find(_key);
-      if (itr != members_->end()) {
-        _key.clear();
+      if (itr != members_->end())
         return itr->second;
-      }
 
       return value_type::null();
     }
 
+    //! Make a key referring to the given string, only for lookup.
     static key_type make_key(const string& key) {
-      key_type _key(key);
+      key_type _key((string_ref(key)));
       return _key;
     }
 
@@ -174,11 +275,14 @@ class Value {
   //! Internal union structure for value types
   union ValueHolder {
     String  s;
+    Short   ss;
     Number  n;
     Object  o;
     Array a;
   };
 
+  static_assert(sizeof(Short) == sizeof(String), "Short must overlay String to share its flags and hash");
+
  public:
   //! null object.
   static Value& null() {
@@ -209,8 +313,10 @@ class Value {
       value_.a.elements_->assign(other.value_.a.begin(), other.value_.a.end());
       break;
     case StringType:
-      value_.s.str_ = new string(*(other.value_.s.str_));
-      value_.s.hash_ = other.value_.s.hash_;
+      if (other.value_.s.flags_ == RefString || other.value_.s.flags_ == ShortString)
+        value_.s = other.value_.s;
+      else
+        setString(other.value_.s.str_, other.value_.s.length_);
       break;
     case NumberType:
       value_.n = other.value_.n;
@@ -230,13 +336,13 @@ class Value {
   }
 
   //! move ctor.
-  Value(Value&& other)
+  Value(Value&& other) noexcept
     : type_(NullType) {
     *this = std::move(other); // delegate to move assignment
   }
 
   //! move assignment operator
-  Value& operator= (Value&& other) {
+  Value& operator= (Value&& other) noexcept {
     if (this != &other) {
       clear();
       type_ = other.type_;
@@ -247,18 +353,22 @@ class Value {
   }
 
   //! ctor with ValueType.
-  Value(ValueType type): type_(type) {
+  /*! \param resource Resource to allocate the elements or members from, such as an Arena or, with C++17,
+      any std::pmr::memory_resource, in which case the value must not outlive it.
+      Values added to the container should be allocated from the same resource.
+   */
+  Value(ValueType type, MemoryResource* resource = 0): type_(type) {
     memset(&value_, 0, sizeof(ValueHolder));
 
     switch (type_) {
     case ObjectType:
-      value_.o.members_ = new typename Object::storage_type;
+      value_.o.members_ = create<typename Object::storage_type>(resource);
       break;
     case ArrayType:
-      value_.a.elements_ = new typename Array::storage_type;
+      value_.a.elements_ = create<typename Array::storage_type>(resource);
       break;
     case StringType:
-      value_.s.str_ = new string();
+      setString(string_ref());
       break;
     default:
       ; // do nothing
@@ -286,9 +396,9 @@ class Value {
 
   //! ctor for numeric array
   template <typename T>
-  Value(T arr, size_t n, typename std::enable_if<std::is_pointer<T>::value>::type* junk = nullptr)
+  Value(T arr, size_t n, typename std::enable_if<std::is_pointer<T>::value, std::nullptr_t>::type = nullptr)
     : Value(ArrayType) {
-    typedef typename std::remove_const<std::remove_pointer<T>::type>::type elem_type;
+    typedef typename std::remove_const<typename std::remove_pointer<T>::type>::type elem_type;
     value_.a.elements_->reserve(n);
 
     std::for_each(arr, arr + n, [&](const elem_type elem) {
@@ -317,22 +427,33 @@ class Value {
   //! ctor for character pointer type.
   Value(const char_type* value)
     : type_(StringType) {
-    value_.s.str_ = new string(value);
-    value_.s.hash_ = std::hash<string>()(*value_.s.str_);
+    setString(value, (size_type)std::char_traits<char_type>::length(value));
   }
 
   //! ctor for string type.
   Value(const string& value)
     : type_(StringType) {
-    value_.s.str_ = new string(value);
-    value_.s.hash_ = std::hash<string>()(*value_.s.str_);
+    setString(value.c_str(), (size_type)value.size());
   }
 
   //! ctor for string type.
   Value(const char_type* begin, const char_type* end)
     : type_(StringType) {
-    value_.s.str_ = new string(begin, end);
-    value_.s.hash_ = std::hash<string>()(*value_.s.str_);
+    setString(begin, (size_type)(end - begin));
+  }
+
+  //! ctor for string type copying characters to a resource, or to the heap if resource is null.
+  Value(const char_type* str, size_type length, MemoryResource* resource)
+    : type_(StringType) {
+    setString(str, length, resource);
+  }
+
+  //! ctor for string type referring to external characters without copying them.
+  /*! The referred characters must be null-terminated and outlive the value.
+   */
+  explicit Value(const string_ref& ref)
+    : type_(StringType) {
+    setString(ref);
   }
 
 #if __cplusplus > 199711L || _MSC_VER >= 1800
@@ -347,25 +468,34 @@ class Value {
   //! @name STL style functions.
   //! @{
 
+  //! Make the value null, releasing its memory.
+  /*! Nested arrays and objects are destroyed without recursion, so values of any depth can be destroyed.
+   */
   void clear() {
     if (type_ == ArrayType || type_ == ObjectType || type_ == StringType) {
+      if (hasNestedContainers())
+        clearNestedContainers();
 
       switch (type_) {
       case ArrayType:
         if (value_.a.elements_) {
           value_.a.clear();
-          delete value_.a.elements_;
+          destroy(value_.a.elements_);
         }
         break;
       case ObjectType:
         if (value_.o.members_) {
           value_.o.clear();
-          delete value_.o.members_;
+          destroy(value_.o.members_);
         }
         break;
       case StringType:
-        if (value_.s.str_)
-          delete value_.s.str_;
+        if (value_.s.flags_ == OwnedString)
+          delete [] value_.s.str_;
+        else if (value_.s.flags_ == ResourceString) {
+          MemoryResource* const* header = reinterpret_cast<MemoryResource* const*>(value_.s.str_) - 1;
+          (*header)->deallocate((void*)header, resourceStringSize(value_.s.length_), alignof(MemoryResource*));
+        }
         break;
       default:
         ;
@@ -426,15 +556,17 @@ class Value {
   }
 
   //! get string value
-  inline const string& asString() const {
-    JSONCXX_ASSERT(type_ == StringType);
-    return *(value_.s.str_);
-  }
-
-  //! get string value
-  inline string& asString() {
+  /*! Strings are not stored as std::basic_string, so they cannot be modified through the result;
+      assign a new string to the value instead, as in v = value(str).
+      Like std::string::c_str(), the reference is invalidated when the value is changed, moved or destroyed.
+      Characters of a short string are stored in the value itself, so moving the value, e.g. by the growth
+      of a vector holding it, leaves the reference dangling; copy the characters with str() to keep them.
+   */
+  inline string_ref asString() const {
     JSONCXX_ASSERT(type_ == StringType);
-    return *(value_.s.str_);
+    if (value_.s.flags_ == ShortString)
+      return string_ref(value_.ss.str(), value_.ss.length());
+    return string_ref(value_.s.str_, value_.s.length_);
   }
 
   //! get natural value
@@ -629,7 +761,7 @@ class Value {
   //! Comparator for map
   bool operator < (const self_type& other) const {
     if (value_.s.hash_ == other.value_.s.hash_)
-      return *value_.s.str_ < *other.value_.s.str_;
+      return asString() < other.asString();
     return value_.s.hash_ < other.value_.s.hash_;
   }
 
@@ -641,8 +773,7 @@ class Value {
 
   inline operator natural() const     { return asNatural(); }
   inline operator real() const      { return asReal(); }
-  inline operator string&()       { return asString(); }
-  inline operator const string&() const { return asString(); }
+  inline operator string() const  { return asString(); }
   inline operator const Number&() const { return asNumber(); }
   inline operator const Array&() const  { return asArray(); }
   inline operator const Object&() const { return asObject(); }
@@ -669,6 +800,130 @@ class Value {
   }
 
  private:
+  //! Check whether the value is an array or an object.
+  inline bool isContainer() const {
+    return (type_ == ArrayType && value_.a.elements_) || (type_ == ObjectType && value_.o.members_);
+  }
+
+  //! Check whether an element or a member of the value is an array or an object.
+  bool hasNestedContainers() const {
+    if (type_ == ArrayType && value_.a.elements_) {
+      for (auto itr = value_.a.begin(); itr != value_.a.end(); ++itr)
+        if (itr->isContainer())
+          return true;
+    } else if (type_ == ObjectType && value_.o.members_) {
+      for (auto itr = value_.o.begin(); itr != value_.o.end(); ++itr)
+        if (itr->second.isContainer())
+          return true;
+    }
+    return false;
+  }
+
+  //! Move the arrays and objects among the elements or members of the value to pending, leaving nulls.
+  void takeNestedContainers(std::vector<Value>& pending) {
+    if (type_ == ArrayType) {
+      for (auto itr = value_.a.begin(); itr != value_.a.end(); ++itr)
+        if (itr->isContainer())
+          pending.push_back(std::move(*itr));
+    } else {
+      for (auto itr = value_.o.begin(); itr != value_.o.end(); ++itr)
+        if (itr->second.isContainer())
+          pending.push_back(std::move(itr->second));
+    }
+  }
+
+  //! Destroy the nested arrays and objects one level at a time from a list on the heap, instead of recursively.
+  /*! Each container is emptied of its own nested containers before it is destroyed, so its destructor does not recurse.
+   */
+  void clearNestedContainers() {
+    std::vector<Value> pending;
+    takeNestedContainers(pending);
+    while (!pending.empty()) {
+      Value container(std::move(pending.back()));
+      pending.pop_back();
+      container.takeNestedContainers(pending);
+    }
+  }
+
+  //! Copy characters to a newly allocated null-terminated string, or in place if it is short.
+  void setString(const char_type* str, size_type length) {
+    if (length <= Short::capacity) {
+      setShortString(str, length);
+      return;
+    }
+
+    char_type* buffer = new char_type[length + 1];
+    std::char_traits<char_type>::copy(buffer, str, length);
+    buffer[length] = 0;
+    value_.s.str_ = buffer;
+    value_.s.length_ = length;
+    value_.s.flags_ = OwnedString;
+    value_.s.hash_ = hashString(str, length);
+  }
+
+  //! Copy characters to a null-terminated string allocated from resource, or from the heap if resource is null.
+  /*! The resource is stored before the characters, to deallocate them from it.
+   */
+  void setString(const char_type* str, size_type length, MemoryResource* resource) {
+    if (!resource || length <= Short::capacity) {
+      setString(str, length);
+      return;
+    }
+
+    void* memory = resource->allocate(resourceStringSize(length), alignof(MemoryResource*));
+    *static_cast<MemoryResource**>(memory) = resource;
+    char_type* buffer = reinterpret_cast<char_type*>(static_cast<MemoryResource**>(memory) + 1);
+    std::char_traits<char_type>::copy(buffer, str, length);
+    buffer[length] = 0;
+    value_.s.str_ = buffer;
+    value_.s.length_ = length;
+    value_.s.flags_ = ResourceString;
+    value_.s.hash_ = hashString(str, length);
+  }
+
+  //! Copy characters in place, which must be at most Short::capacity.
+  void setShortString(const char_type* str, size_type length) {
+    char_type* buffer = value_.ss.str();
+    std::char_traits<char_type>::copy(buffer, str, length);
+    buffer[length] = 0;
+    buffer[Short::capacity] = (char_type)(Short::capacity - length);
+    value_.ss.flags_ = ShortString;
+    value_.ss.hash_ = hashString(str, length);
+  }
+
+  //! Get the size of the memory of a string allocated from a resource.
+  static inline size_t resourceStringSize(size_type length) {
+    return sizeof(MemoryResource*) + (length + 1) * sizeof(char_type);
+  }
+
+  //! Refer to external characters.
+  void setString(const string_ref& ref) {
+    value_.s.str_ = ref.c_str();
+    value_.s.length_ = ref.length();
+    value_.s.flags_ = RefString;
+    value_.s.hash_ = hashString(ref.data(), ref.length());
+  }
+
+  //! Create storage of a container, in resource if it is not null.
+  template <typename Storage>
+  static Storage* create(MemoryResource* resource) {
+    if (!resource)
+      return new Storage;
+    typedef typename Storage::allocator_type allocator_type;
+    return new (resource->allocate(sizeof(Storage), alignof(Storage))) Storage(allocator_type(resource));
+  }
+
+  //! Destroy storage of a container created by create().
+  template <typename Storage>
+  static void destroy(Storage* storage) {
+    MemoryResource* resource = storage->get_allocator().resource();
+    if (resource) {
+      storage->~Storage();
+      resource->deallocate(storage, sizeof(Storage), alignof(Storage));
+    } else
+      delete storage;
+  }
+
   ValueHolder     value_;
   ValueType   type_;
 };
@@ -683,15 +938,16 @@ namespace std {
 
 //! template specialization of std::hash for Value type
 template <typename Encoding>
-struct hash<jsoncxx::Value<Encoding> >
-  : public unary_function<jsoncxx::Value<Encoding>, size_t> {
+struct hash<jsoncxx::Value<Encoding> > {
+  typedef jsoncxx::Value<Encoding>  argument_type;
+  typedef size_t                    result_type;
   typedef std::basic_string<typename Encoding::char_type> string;
 
   size_t operator()(const jsoncxx::Value<Encoding>& _KeyVal) const {
     if (_KeyVal.type() != jsoncxx::StringType)
       throw std::runtime_error("Non-String type Value cannot have hash value!");
 
-    return hash<string>()(_KeyVal.asString());
+    return jsoncxx::hashString(_KeyVal.asString().data(), _KeyVal.asString().length());
   }
 };
 
@@ -86,9 +86,10 @@ class Writer {
       stream_ << n.num_.r;
   }
 
-  void writeString(const string& s) {
+  //! Write the characters of a string by its length, since it may hold null characters.
+  void writeString(const typename Value<Encoding>::string_ref& s) {
     stream_.put('\"');
-    stream_ << s.c_str();
+    stream_.write(s.data(), s.length());
     stream_.put('\"');
   }
 